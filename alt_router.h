@@ -0,0 +1,326 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "dijkstra.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Point-to-point queries without a route table: bidirectional A* whose potentials are lower bounds
+    // taken from the distances to and from a few landmark vertices (ALT: A*, landmarks, triangle
+    // inequality). Preprocessing is two one-to-all searches per landmark.
+    template <typename Weight>
+    class AltRouter {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename Router<Weight>::RouteInfo;
+
+        // distances of every vertex from and to each landmark, one row of landmark_count values per vertex
+        struct Landmarks {
+            std::vector<VertexId> vertices;
+            std::vector<Weight> from_landmark;
+            std::vector<Weight> to_landmark;
+        };
+
+        AltRouter(const Graph& graph, size_t landmark_count);
+        // the landmarks of other over graph, a copy of its graph
+        AltRouter(const Graph& graph, const AltRouter& other)
+            : graph_(graph)
+            , landmarks_(other.landmarks_)
+            , incoming_edges_(other.incoming_edges_) {
+        }
+
+        /* for serialization */
+        template <typename LandmarksType>
+        AltRouter(const Graph& graph, LandmarksType&& landmarks)
+            : graph_(graph)
+            , landmarks_(std::forward<LandmarksType>(landmarks)) {
+            IndexIncomingEdges();
+        }
+
+        const Landmarks& GetLandmarks() const {
+            return landmarks_;
+        }
+        /* ------------------ */
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, SearchStats* stats = nullptr) const;
+
+        // recomputes the landmark distances for the same landmarks after edges were changed, added or removed
+        void Rebuild();
+
+    private:
+        static constexpr Weight UNREACHABLE = std::numeric_limits<Weight>::max();
+        static constexpr Weight ZERO_WEIGHT{};
+
+        const Graph& graph_;
+        Landmarks landmarks_;
+        std::vector<std::vector<EdgeId>> incoming_edges_;
+
+        void IndexIncomingEdges();
+        // one-to-all distances along the edges, or against them when reverse is set
+        std::vector<Weight> ComputeDistances(VertexId source, bool reverse) const;
+        // farthest-first: each next landmark is the vertex farthest from the ones already chosen
+        void SelectLandmarks(size_t landmark_count);
+        void ComputeLandmarkDistances();
+        // lower bound of the distance from vertex to target
+        Weight GetLowerBound(VertexId vertex, VertexId target) const;
+    };
+
+    template <typename Weight>
+    AltRouter<Weight>::AltRouter(const Graph& graph, size_t landmark_count)
+        : graph_(graph) {
+        IndexIncomingEdges();
+        SelectLandmarks(landmark_count);
+        ComputeLandmarkDistances();
+    }
+
+    template <typename Weight>
+    void AltRouter<Weight>::Rebuild() {
+        IndexIncomingEdges();
+        ComputeLandmarkDistances();
+    }
+
+    template <typename Weight>
+    void AltRouter<Weight>::IndexIncomingEdges() {
+        incoming_edges_.assign(graph_.GetVertexCount(), {});
+        for (VertexId vertex = 0; vertex < graph_.GetVertexCount(); ++vertex) {
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                if (edge.weight < ZERO_WEIGHT) {
+                    throw std::domain_error("Edges' weights should be non-negative");
+                }
+                incoming_edges_[edge.to].push_back(edge_id);
+            }
+        }
+    }
+
+    template <typename Weight>
+    std::vector<Weight> AltRouter<Weight>::ComputeDistances(VertexId source, bool reverse) const {
+        using Item = std::pair<Weight, VertexId>;
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+        std::vector<Weight> distances(graph_.GetVertexCount(), UNREACHABLE);
+
+        distances[source] = ZERO_WEIGHT;
+        queue.push({ ZERO_WEIGHT, source });
+        while (!queue.empty()) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (weight > distances[vertex]) {
+                continue;
+            }
+            auto relax = [&](EdgeId edge_id) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const VertexId next = reverse ? edge.from : edge.to;
+                if (weight + edge.weight < distances[next]) {
+                    distances[next] = weight + edge.weight;
+                    queue.push({ distances[next], next });
+                }
+            };
+            if (reverse) {
+                std::for_each(incoming_edges_[vertex].begin(), incoming_edges_[vertex].end(), relax);
+            }
+            else {
+                for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                    relax(edge_id);
+                }
+            }
+        }
+        return distances;
+    }
+
+    template <typename Weight>
+    void AltRouter<Weight>::SelectLandmarks(size_t landmark_count) {
+        const size_t vertex_count = graph_.GetVertexCount();
+        landmarks_.vertices.clear();
+        if (vertex_count == 0) {
+            return;
+        }
+
+        // round-trip distance to the nearest landmark chosen so far
+        std::vector<Weight> nearest(vertex_count, UNREACHABLE);
+        auto add_source = [&](VertexId source) {
+            const std::vector<Weight> from_source = ComputeDistances(source, false);
+            const std::vector<Weight> to_source = ComputeDistances(source, true);
+            for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+                if (from_source[vertex] != UNREACHABLE && to_source[vertex] != UNREACHABLE) {
+                    nearest[vertex] = std::min(nearest[vertex], from_source[vertex] + to_source[vertex]);
+                }
+            }
+        };
+
+        // isolated vertices give no bounds and are never picked
+        std::vector<bool> is_candidate(vertex_count);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            const auto outgoing = graph_.GetIncidentEdges(vertex);
+            is_candidate[vertex] = !incoming_edges_[vertex].empty() || outgoing.begin() != outgoing.end();
+        }
+
+        // vertex 0 is only where the search starts: the first landmark is the vertex farthest from it.
+        // Vertices no landmark reaches both ways count as the farthest, they lie in another part of the network
+        add_source(0);
+        while (landmarks_.vertices.size() < landmark_count) {
+            std::optional<VertexId> farthest;
+            for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+                if (is_candidate[vertex] && (!farthest || nearest[vertex] > nearest[*farthest])) {
+                    farthest = vertex;
+                }
+            }
+            if (!farthest) {
+                break;
+            }
+            if (landmarks_.vertices.empty()) {
+                nearest.assign(vertex_count, UNREACHABLE);
+            }
+            is_candidate[*farthest] = false;
+            landmarks_.vertices.push_back(*farthest);
+            add_source(*farthest);
+        }
+    }
+
+    template <typename Weight>
+    void AltRouter<Weight>::ComputeLandmarkDistances() {
+        const size_t vertex_count = graph_.GetVertexCount();
+        const size_t landmark_count = landmarks_.vertices.size();
+        landmarks_.from_landmark.assign(vertex_count * landmark_count, UNREACHABLE);
+        landmarks_.to_landmark.assign(vertex_count * landmark_count, UNREACHABLE);
+        for (size_t landmark = 0; landmark < landmark_count; ++landmark) {
+            const std::vector<Weight> from = ComputeDistances(landmarks_.vertices[landmark], false);
+            const std::vector<Weight> to = ComputeDistances(landmarks_.vertices[landmark], true);
+            for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+                landmarks_.from_landmark[vertex * landmark_count + landmark] = from[vertex];
+                landmarks_.to_landmark[vertex * landmark_count + landmark] = to[vertex];
+            }
+        }
+    }
+
+    template <typename Weight>
+    Weight AltRouter<Weight>::GetLowerBound(VertexId vertex, VertexId target) const {
+        const size_t landmark_count = landmarks_.vertices.size();
+        const Weight* from_vertex = landmarks_.from_landmark.data() + vertex * landmark_count;
+        const Weight* from_target = landmarks_.from_landmark.data() + target * landmark_count;
+        const Weight* to_vertex = landmarks_.to_landmark.data() + vertex * landmark_count;
+        const Weight* to_target = landmarks_.to_landmark.data() + target * landmark_count;
+
+        Weight bound = ZERO_WEIGHT;
+        for (size_t landmark = 0; landmark < landmark_count; ++landmark) {
+            // d(l, target) <= d(l, vertex) + d(vertex, target) and d(vertex, l) <= d(vertex, target) + d(target, l)
+            if (from_target[landmark] != UNREACHABLE && from_vertex[landmark] != UNREACHABLE) {
+                bound = std::max(bound, from_target[landmark] - from_vertex[landmark]);
+            }
+            if (to_vertex[landmark] != UNREACHABLE && to_target[landmark] != UNREACHABLE) {
+                bound = std::max(bound, to_vertex[landmark] - to_target[landmark]);
+            }
+        }
+        return bound;
+    }
+
+    template <typename Weight>
+    std::optional<typename AltRouter<Weight>::RouteInfo> AltRouter<Weight>::BuildRoute(VertexId from, VertexId to,
+        SearchStats* stats) const {
+        if (from == to) {
+            return RouteInfo{ ZERO_WEIGHT, {} };
+        }
+
+        // Both searches use the average potential p(v) = (bound(v, to) - bound(from, v)) / 2, forward keys
+        // are distance + p and backward keys distance - p. The reduced edge weights are then the same in
+        // both directions, so the usual bidirectional stop rule holds: the top keys sum to the best meeting.
+        // Keys are kept doubled, 2 * distance +- 2p, so that integer weights need no halving.
+        const size_t vertex_count = graph_.GetVertexCount();
+        std::vector<Weight> potential(vertex_count);
+        std::vector<bool> has_potential(vertex_count, false);
+        auto get_potential = [&](VertexId vertex) {
+            if (!has_potential[vertex]) {
+                potential[vertex] = GetLowerBound(vertex, to) - GetLowerBound(from, vertex);
+                has_potential[vertex] = true;
+            }
+            return potential[vertex];
+        };
+
+        struct Side {
+            std::vector<Weight> distance;
+            std::vector<std::optional<EdgeId>> edge; // the last edge of the best path found, toward the side's source
+            std::vector<bool> is_settled;
+            std::priority_queue<std::pair<Weight, VertexId>, std::vector<std::pair<Weight, VertexId>>,
+                std::greater<std::pair<Weight, VertexId>>> queue;
+        };
+        Side sides[2];
+        for (Side& side : sides) {
+            side.distance.assign(vertex_count, UNREACHABLE);
+            side.edge.assign(vertex_count, std::nullopt);
+            side.is_settled.assign(vertex_count, false);
+        }
+        sides[0].distance[from] = ZERO_WEIGHT;
+        sides[0].queue.push({ get_potential(from), from });
+        sides[1].distance[to] = ZERO_WEIGHT;
+        sides[1].queue.push({ -get_potential(to), to });
+
+        Weight best = UNREACHABLE;
+        std::optional<VertexId> meeting;
+        while (!sides[0].queue.empty() && !sides[1].queue.empty()) {
+            if (best != UNREACHABLE && sides[0].queue.top().first + sides[1].queue.top().first >= 2 * best) {
+                break;
+            }
+            const bool reverse = sides[1].queue.top().first < sides[0].queue.top().first;
+            Side& side = sides[reverse];
+            const Side& other = sides[!reverse];
+            const VertexId vertex = side.queue.top().second;
+            side.queue.pop();
+            if (side.is_settled[vertex]) {
+                continue;
+            }
+            side.is_settled[vertex] = true;
+            if (stats) {
+                ++stats->settled;
+            }
+
+            auto relax = [&](EdgeId edge_id) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const VertexId next = reverse ? edge.from : edge.to;
+                const Weight candidate = side.distance[vertex] + edge.weight;
+                if (candidate >= side.distance[next]) {
+                    return;
+                }
+                side.distance[next] = candidate;
+                side.edge[next] = edge_id;
+                side.queue.push({ 2 * candidate + (reverse ? -get_potential(next) : get_potential(next)), next });
+                if (other.distance[next] != UNREACHABLE && candidate + other.distance[next] < best) {
+                    best = candidate + other.distance[next];
+                    meeting = next;
+                }
+            };
+            if (reverse) {
+                std::for_each(incoming_edges_[vertex].begin(), incoming_edges_[vertex].end(), relax);
+            }
+            else {
+                for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                    relax(edge_id);
+                }
+            }
+        }
+
+        if (!meeting) {
+            return std::nullopt;
+        }
+        std::vector<EdgeId> edges;
+        for (VertexId vertex = *meeting; sides[0].edge[vertex]; vertex = graph_.GetEdge(*sides[0].edge[vertex]).from) {
+            edges.push_back(*sides[0].edge[vertex]);
+        }
+        std::reverse(edges.begin(), edges.end());
+        for (VertexId vertex = *meeting; sides[1].edge[vertex]; vertex = graph_.GetEdge(*sides[1].edge[vertex]).to) {
+            edges.push_back(*sides[1].edge[vertex]);
+        }
+        return RouteInfo{ best, std::move(edges) };
+    }
+
+}  // namespace graph
@@ -0,0 +1,141 @@
+#include "catalogue_snapshot.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace transport_catalogue {
+
+	/* ------ NetworkEdit ------ */
+	void NetworkEdit::AddBus(std::string_view bus, const std::vector<uint32_t>& route, bool is_circle) {
+		catalogue_.AddBus(bus, route, is_circle);
+		if (router_) {
+			router_->AddBus(catalogue_, bus);
+		}
+	}
+
+	void NetworkEdit::RemoveBus(std::string_view bus) {
+		catalogue_.RemoveBus(bus);
+		if (router_) {
+			router_->RemoveBus(catalogue_, bus);
+		}
+	}
+
+	void NetworkEdit::UpdateBusRoute(std::string_view bus, const std::vector<uint32_t>& route, bool is_circle) {
+		catalogue_.UpdateBusRoute(bus, route, is_circle);
+		if (router_) {
+			router_->UpdateBusRoute(catalogue_, bus);
+		}
+	}
+
+	void NetworkEdit::MoveStop(std::string_view stop, geo::Coordinates coords) {
+		catalogue_.MoveStop(stop, coords);
+	}
+
+	void NetworkEdit::UpdateDistance(std::string_view from, std::string_view to, size_t distance) {
+		catalogue_.UpdateDistance(from, to, distance);
+		if (router_) {
+			router_->UpdateDistance(catalogue_, from, to);
+		}
+	}
+
+	std::unique_ptr<Snapshot> BuildSnapshot(std::shared_ptr<const TransportCatalogue> catalogue,
+		std::unique_ptr<TransportRouter> router,
+		const std::optional<interfaces::MapRenderer::Settings>& render_settings,
+		const Timetable& timetable) {
+		auto snapshot = std::make_unique<Snapshot>();
+		if (router) {
+			if (!timetable.empty()) {
+				snapshot->timetable_router = std::make_shared<const TimetableRouter>(*catalogue, router->GetTransportGraph(), timetable);
+			}
+			snapshot->router = std::move(router);
+		}
+		snapshot->render_settings = render_settings;
+		snapshot->catalogue = std::move(catalogue);
+		return snapshot;
+	}
+
+	/* ------ Snapshot ------ */
+	const std::string& Snapshot::GetMap() const {
+		std::call_once(map_rendered_, [this] {
+			interfaces::MapRenderer renderer;
+			renderer.SetSettings(render_settings.value());
+			const auto& buses = catalogue->GetAllBuses();
+			std::ostringstream stream;
+			renderer.DrawMap(stream, { buses.begin(), buses.end() }, catalogue->GetAllStops());
+			map_ = stream.str();
+		});
+		return map_;
+	}
+
+	/* ------ SnapshotStore::Guard ------ */
+	SnapshotStore::Guard::~Guard() {
+		slot_.store(0);
+	}
+
+	/* ------ SnapshotStore::Reader ------ */
+	SnapshotStore::Reader::Reader(Reader&& other) noexcept
+		: store_(other.store_), slot_(other.slot_) {
+		other.store_ = nullptr;
+	}
+
+	SnapshotStore::Reader::~Reader() {
+		if (store_) {
+			const_cast<SnapshotStore*>(store_)->slot_taken_[slot_].store(false);
+		}
+	}
+
+	SnapshotStore::Guard SnapshotStore::Reader::Pin() const {
+		std::atomic<uint64_t>& slot = const_cast<SnapshotStore*>(store_)->reader_epochs_[slot_];
+		// announce the epoch before looking at the pointer, so a writer cannot free what we load
+		slot.store(store_->epoch_.load());
+		return Guard(slot, store_->current_.load());
+	}
+
+	/* ------ SnapshotStore ------ */
+	SnapshotStore::SnapshotStore(std::unique_ptr<Snapshot> initial)
+		: current_(initial.release()) {
+	}
+
+	SnapshotStore::~SnapshotStore() {
+		delete current_.load();
+	}
+
+	SnapshotStore::Reader SnapshotStore::RegisterReader() {
+		for (size_t slot = 0; slot < MAX_READERS; ++slot) {
+			bool expected = false;
+			if (slot_taken_[slot].compare_exchange_strong(expected, true)) {
+				return Reader(*this, slot);
+			}
+		}
+		throw std::runtime_error("Too many snapshot readers");
+	}
+
+	void SnapshotStore::Publish(std::unique_ptr<Snapshot> next) {
+		std::lock_guard guard(writer_mutex_);
+		next->version = ++version_;
+		const Snapshot* old = current_.exchange(next.release());
+		// readers announcing this epoch or a later one load the new pointer
+		const uint64_t retire_epoch = epoch_.fetch_add(1);
+		retired_.push_back({ std::unique_ptr<const Snapshot>(old), retire_epoch });
+		ReclaimLocked();
+	}
+
+	void SnapshotStore::Reclaim() {
+		std::lock_guard guard(writer_mutex_);
+		ReclaimLocked();
+	}
+
+	void SnapshotStore::ReclaimLocked() {
+		uint64_t min_active = UINT64_MAX;
+		for (const auto& slot : reader_epochs_) {
+			const uint64_t epoch = slot.load();
+			if (epoch != 0) {
+				min_active = std::min(min_active, epoch);
+			}
+		}
+		retired_.erase(std::remove_if(retired_.begin(), retired_.end(),
+			[min_active](const Retired& item) { return item.epoch < min_active; }), retired_.end());
+	}
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "transport_catalogue.h"
+#include "transport_router.h"
+#include "timetable_router.h"
+#include "map_renderer.h"
+
+namespace transport_catalogue {
+
+	// one immutable version of everything queries run against; the first one shares the loaded catalogue
+	// and router rather than copying them
+	struct Snapshot {
+		uint64_t version = 0;
+		std::shared_ptr<const TransportCatalogue> catalogue;
+		std::shared_ptr<const TransportRouter> router; // null without routing settings
+		std::shared_ptr<const TimetableRouter> timetable_router; // null without a router or a timetable
+		std::optional<interfaces::MapRenderer::Settings> render_settings; // empty without a map
+
+		// the SVG of this version, rendered by the first Map request to it; a version nobody draws costs nothing
+		const std::string& GetMap() const;
+
+	private:
+		mutable std::once_flag map_rendered_;
+		mutable std::string map_;
+	};
+
+	// live changes of the next version: each one is applied to its catalogue, then to its router, which
+	// patches its graph and route table instead of being rebuilt. A bus is added or rerouted once the
+	// distances along its route are set
+	class NetworkEdit {
+	public:
+		NetworkEdit(TransportCatalogue& catalogue, TransportRouter* router)
+			: catalogue_(catalogue), router_(router) {
+		}
+
+		void AddBus(std::string_view bus, const std::vector<uint32_t>& route, bool is_circle);
+		void RemoveBus(std::string_view bus);
+		void UpdateBusRoute(std::string_view bus, const std::vector<uint32_t>& route, bool is_circle);
+		void MoveStop(std::string_view stop, geo::Coordinates coords); // routes do not depend on coordinates
+		void UpdateDistance(std::string_view from, std::string_view to, size_t distance);
+
+		const TransportCatalogue& GetCatalogue() const {
+			return catalogue_;
+		}
+
+	private:
+		TransportCatalogue& catalogue_;
+		TransportRouter* router_; // null without routing settings
+	};
+
+	// completes the next version off to the side, from its catalogue and its edited or reweighted router: the
+	// timetable router is built here, under no lock
+	std::unique_ptr<Snapshot> BuildSnapshot(std::shared_ptr<const TransportCatalogue> catalogue,
+		std::unique_ptr<TransportRouter> router,
+		const std::optional<interfaces::MapRenderer::Settings>& render_settings,
+		const Timetable& timetable);
+
+	// Read-mostly holder of the current snapshot. Readers pin it with an atomic load and never wait
+	// for writers; a replaced snapshot is freed once every reader that could see it has unpinned
+	// (epoch-based reclamation). Writers are serialized among themselves.
+	class SnapshotStore {
+	public:
+		static constexpr size_t MAX_READERS = 64;
+
+		class Guard {
+		public:
+			Guard(const Guard&) = delete;
+			Guard& operator=(const Guard&) = delete;
+			~Guard();
+
+			const Snapshot& operator*() const {
+				return *snapshot_;
+			}
+			const Snapshot* operator->() const {
+				return snapshot_;
+			}
+
+		private:
+			friend class SnapshotStore;
+			Guard(std::atomic<uint64_t>& slot, const Snapshot* snapshot)
+				: slot_(slot), snapshot_(snapshot) {
+			}
+
+			std::atomic<uint64_t>& slot_;
+			const Snapshot* snapshot_;
+		};
+
+		// one per reading thread; a reader holds at most one guard at a time
+		class Reader {
+		public:
+			Reader(Reader&& other) noexcept;
+			Reader(const Reader&) = delete;
+			Reader& operator=(const Reader&) = delete;
+			~Reader();
+
+			Guard Pin() const;
+
+		private:
+			friend class SnapshotStore;
+			Reader(const SnapshotStore& store, size_t slot)
+				: store_(&store), slot_(slot) {
+			}
+
+			const SnapshotStore* store_;
+			size_t slot_;
+		};
+
+		explicit SnapshotStore(std::unique_ptr<Snapshot> initial);
+		SnapshotStore(const SnapshotStore&) = delete;
+		SnapshotStore& operator=(const SnapshotStore&) = delete;
+		~SnapshotStore();
+
+		Reader RegisterReader();
+		void Publish(std::unique_ptr<Snapshot> next);
+		void Reclaim(); // frees replaced snapshots no reader can see any more
+
+	private:
+		struct Retired {
+			std::unique_ptr<const Snapshot> snapshot;
+			uint64_t epoch;
+		};
+
+		std::atomic<const Snapshot*> current_;
+		std::atomic<uint64_t> epoch_ = 1; // 0 marks an idle reader slot
+		std::array<std::atomic<uint64_t>, MAX_READERS> reader_epochs_ = {};
+		std::array<std::atomic<bool>, MAX_READERS> slot_taken_ = {};
+
+		std::mutex writer_mutex_;
+		uint64_t version_ = 0;
+		std::vector<Retired> retired_;
+
+		void ReclaimLocked();
+	};
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Strongly connected components: vertices reaching each other both ways share a label. A closed
+    // component has no edge leaving it, so nothing outside is reachable from its vertices.
+    struct Components {
+        std::vector<uint32_t> component_by_vertex;
+        std::vector<bool> is_closed; // by component
+
+        size_t GetCount() const {
+            return is_closed.size();
+        }
+
+        // with every component closed, the components split reachability exactly
+        bool AreAllClosed() const {
+            return std::find(is_closed.begin(), is_closed.end(), false) == is_closed.end();
+        }
+
+        // O(1), true only when no route can exist; a component with edges leaving it still needs a search
+        bool IsUnreachable(VertexId from, VertexId to) const {
+            const uint32_t component = component_by_vertex[from];
+            return component != component_by_vertex[to] && is_closed[component];
+        }
+    };
+
+    // Tarjan's algorithm, with an explicit stack instead of recursion
+    template <typename Weight>
+    Components FindStronglyConnectedComponents(const DirectedWeightedGraph<Weight>& graph) {
+        constexpr uint32_t UNVISITED = std::numeric_limits<uint32_t>::max();
+        const size_t vertex_count = graph.GetVertexCount();
+        Components components;
+        components.component_by_vertex.assign(vertex_count, UNVISITED);
+
+        std::vector<uint32_t> order(vertex_count, UNVISITED); // discovery order
+        std::vector<uint32_t> low(vertex_count, 0);
+        std::vector<bool> on_stack(vertex_count, false);
+        std::vector<VertexId> stack;
+        std::vector<std::pair<VertexId, size_t>> path; // a vertex and its next incident edge to look at
+        uint32_t next_order = 0;
+
+        auto visit = [&](VertexId vertex) {
+            order[vertex] = low[vertex] = next_order++;
+            stack.push_back(vertex);
+            on_stack[vertex] = true;
+            path.push_back({ vertex, 0 });
+        };
+
+        for (VertexId root = 0; root < vertex_count; ++root) {
+            if (order[root] != UNVISITED) {
+                continue;
+            }
+            visit(root);
+            while (!path.empty()) {
+                const auto [vertex, position] = path.back();
+                const auto edges = graph.GetIncidentEdges(vertex);
+                if (edges.begin() + position != edges.end()) {
+                    ++path.back().second;
+                    const VertexId next = graph.GetEdge(*(edges.begin() + position)).to;
+                    if (order[next] == UNVISITED) {
+                        visit(next);
+                    }
+                    else if (on_stack[next]) {
+                        low[vertex] = std::min(low[vertex], order[next]);
+                    }
+                    continue;
+                }
+
+                path.pop_back();
+                if (!path.empty()) {
+                    low[path.back().first] = std::min(low[path.back().first], low[vertex]);
+                }
+                if (low[vertex] == order[vertex]) {
+                    const uint32_t component = static_cast<uint32_t>(components.is_closed.size());
+                    components.is_closed.push_back(true);
+                    VertexId member;
+                    do {
+                        member = stack.back();
+                        stack.pop_back();
+                        on_stack[member] = false;
+                        components.component_by_vertex[member] = component;
+                    } while (member != vertex);
+                }
+            }
+        }
+
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            const uint32_t component = components.component_by_vertex[vertex];
+            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+                if (components.component_by_vertex[graph.GetEdge(edge_id).to] != component) {
+                    components.is_closed[component] = false;
+                }
+            }
+        }
+        return components;
+    }
+
+}  // namespace graph
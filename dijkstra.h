@@ -0,0 +1,144 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    template <typename Weight>
+    struct ReachedVertex {
+        VertexId vertex;
+        Weight weight;
+    };
+
+    // work done by one search, for comparing search strategies
+    struct SearchStats {
+        size_t settled = 0;
+    };
+
+    // Single-source Dijkstra cut off at the budget: every vertex whose shortest path weighs no more
+    // than budget, in the order the search settles them (by nondecreasing weight).
+    template <typename Weight>
+    std::vector<ReachedVertex<Weight>> FindReachable(const DirectedWeightedGraph<Weight>& graph, VertexId source, Weight budget) {
+        using Item = std::pair<Weight, VertexId>;
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+        std::vector<Weight> best(graph.GetVertexCount(), std::numeric_limits<Weight>::max());
+        std::vector<ReachedVertex<Weight>> reached;
+
+        best.at(source) = Weight{};
+        queue.push({ Weight{}, source });
+        while (!queue.empty()) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (weight > best[vertex]) {
+                continue; // a stale entry, the vertex was settled with less
+            }
+            reached.push_back({ vertex, weight });
+
+            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+                const auto& edge = graph.GetEdge(edge_id);
+                const Weight candidate = weight + edge.weight;
+                if (candidate <= budget && candidate < best[edge.to]) {
+                    best[edge.to] = candidate;
+                    queue.push({ candidate, edge.to });
+                }
+            }
+        }
+        return reached;
+    }
+
+    // the shortest paths from one source to every vertex: a route to any target is a walk back along edges
+    template <typename Weight>
+    struct ShortestPathTree {
+        static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+        VertexId source;
+        std::vector<Weight> weights;      // numeric_limits<Weight>::max() for unreached vertices
+        std::vector<EdgeId> parent_edges; // the last edge of the path, NO_EDGE at the source and unreached vertices
+    };
+
+    template <typename Weight>
+    ShortestPathTree<Weight> BuildShortestPathTree(const DirectedWeightedGraph<Weight>& graph, VertexId source) {
+        using Item = std::pair<Weight, VertexId>;
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+        ShortestPathTree<Weight> tree{ source,
+            std::vector<Weight>(graph.GetVertexCount(), std::numeric_limits<Weight>::max()),
+            std::vector<EdgeId>(graph.GetVertexCount(), ShortestPathTree<Weight>::NO_EDGE) };
+
+        tree.weights.at(source) = Weight{};
+        queue.push({ Weight{}, source });
+        while (!queue.empty()) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (weight > tree.weights[vertex]) {
+                continue;
+            }
+            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+                const auto& edge = graph.GetEdge(edge_id);
+                const Weight candidate = weight + edge.weight;
+                if (candidate < tree.weights[edge.to]) {
+                    tree.weights[edge.to] = candidate;
+                    tree.parent_edges[edge.to] = edge_id;
+                    queue.push({ candidate, edge.to });
+                }
+            }
+        }
+        return tree;
+    }
+
+    // the edges from the source of the tree to a vertex it reached
+    template <typename Weight>
+    std::vector<EdgeId> GetTreePath(const DirectedWeightedGraph<Weight>& graph, const ShortestPathTree<Weight>& tree, VertexId to) {
+        std::vector<EdgeId> edges;
+        for (VertexId vertex = to; vertex != tree.source;) {
+            const EdgeId edge_id = tree.parent_edges[vertex];
+            edges.push_back(edge_id);
+            vertex = graph.GetEdge(edge_id).from;
+        }
+        std::reverse(edges.begin(), edges.end());
+        return edges;
+    }
+
+    // Plain point-to-point Dijkstra, stopping once the target is settled. Kept as the baseline the
+    // goal-directed searches are measured against.
+    template <typename Weight>
+    std::optional<Weight> FindDistance(const DirectedWeightedGraph<Weight>& graph, VertexId from, VertexId to,
+        SearchStats* stats = nullptr) {
+        using Item = std::pair<Weight, VertexId>;
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+        std::vector<Weight> best(graph.GetVertexCount(), std::numeric_limits<Weight>::max());
+
+        best.at(from) = Weight{};
+        queue.push({ Weight{}, from });
+        while (!queue.empty()) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (weight > best[vertex]) {
+                continue;
+            }
+            if (stats) {
+                ++stats->settled;
+            }
+            if (vertex == to) {
+                return weight;
+            }
+            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+                const auto& edge = graph.GetEdge(edge_id);
+                const Weight candidate = weight + edge.weight;
+                if (candidate < best[edge.to]) {
+                    best[edge.to] = candidate;
+                    queue.push({ candidate, edge.to });
+                }
+            }
+        }
+        return std::nullopt;
+    }
+
+}  // namespace graph
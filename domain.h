@@ -1,5 +1,8 @@
 #pragma once
 #include "geo.h"
+#include <cassert>
+#include <cstdint>
+#include <iterator>
 #include <string>
 #include <vector>
 #include <string_view>
@@ -9,17 +12,75 @@ namespace transport_catalogue {
 
 	namespace domain {
 
+		// names are views, the catalogue owns the characters
 		struct Stop {
-			std::string stop;
+			std::string_view stop;
 			geo::Coordinates coords;
+			size_t id = 0; // position in the catalogue, assigned by AddStop
 		};
 
 		bool operator<(const Stop& left, const Stop& right);
 
+		// stop IDs of one bus route: a [first, last) span of the catalogue's route pool
+		class RouteView {
+		public:
+			using Iterator = const uint32_t*;
+			using ReverseIterator = std::reverse_iterator<Iterator>;
+
+			RouteView() = default;
+			RouteView(const std::vector<uint32_t>* pool, uint32_t first, uint32_t last)
+				: pool_(pool), first_(first), last_(last) {
+			}
+			// the same span of a copy of the pool
+			RouteView Rebind(const std::vector<uint32_t>* pool) const {
+				return RouteView(pool, first_, last_);
+			}
+
+			// an empty view points into EMPTY_ROUTE, never at null, so that iterator arithmetic on it stays defined
+			Iterator begin() const {
+				return empty() ? EMPTY_ROUTE : pool_->data() + first_;
+			}
+			Iterator end() const {
+				return empty() ? EMPTY_ROUTE : pool_->data() + last_;
+			}
+			ReverseIterator rbegin() const {
+				return ReverseIterator(end());
+			}
+			ReverseIterator rend() const {
+				return ReverseIterator(begin());
+			}
+
+			size_t size() const {
+				return last_ - first_;
+			}
+			bool empty() const {
+				return first_ == last_;
+			}
+			uint32_t operator[](size_t index) const {
+				return begin()[index];
+			}
+			uint32_t front() const {
+				assert(!empty());
+				return (*pool_)[first_];
+			}
+			uint32_t back() const {
+				assert(!empty());
+				return (*pool_)[last_ - 1];
+			}
+
+		private:
+			static constexpr uint32_t EMPTY_ROUTE[1] = {};
+
+			const std::vector<uint32_t>* pool_ = nullptr;
+			uint32_t first_ = 0;
+			uint32_t last_ = 0;
+		};
+
 		struct Bus {
-			std::string bus;
-			std::vector<const Stop*> route;
+			std::string_view bus;
+			RouteView route;
 			bool is_circle;
+			size_t id = 0; // position in the catalogue, assigned by AddBus
 		};
 
 		bool operator<(const Bus& left, const Bus& right);
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath> 
 #include <corecrt_math_defines.h>
+#include <cstdint>
+#include <utility>
+#include <vector>
 
 namespace geo {
 
@@ -28,5 +32,82 @@ namespace geo {
             + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
             * EARTH_RADIUS;
     }
-}
 
+    // position of the point along a Hilbert curve filling the box on a 2^16 x 2^16 grid: points close on the
+    // curve are close on the map, so sorting by it keeps neighbours together
+    inline uint64_t ComputeHilbertIndex(Coordinates point, Coordinates min, Coordinates max) {
+        constexpr uint32_t SIDE = 1u << 16;
+        auto to_cell = [](double value, double low, double high) {
+            const double share = high > low ? (value - low) / (high - low) : 0.0;
+            return static_cast<uint32_t>(std::min(std::max(share, 0.0) * SIDE, SIDE - 1.0));
+        };
+        uint32_t x = to_cell(point.lng, min.lng, max.lng);
+        uint32_t y = to_cell(point.lat, min.lat, max.lat);
+        uint64_t index = 0;
+        for (uint32_t half = SIDE / 2; half > 0; half /= 2) {
+            const uint32_t rx = (x & half) ? 1 : 0;
+            const uint32_t ry = (y & half) ? 1 : 0;
+            index += static_cast<uint64_t>(half) * half * ((3 * rx) ^ ry);
+            // rotate the quadrant so the curve inside it starts and ends where the coarser one expects
+            if (ry == 0) {
+                if (rx == 1) {
+                    x = SIDE - 1 - x;
+                    y = SIDE - 1 - y;
+                }
+                std::swap(x, y);
+            }
+        }
+        return index;
+    }
+
+    // per-point trigonometry computed once, stored as a struct of arrays
+    struct CoordinatesTable {
+        std::vector<double> sin_lat;
+        std::vector<double> cos_lat;
+        std::vector<double> lng;
+
+        void Add(Coordinates coords) {
+            static const double dr = M_PI / 180.;
+            sin_lat.push_back(std::sin(coords.lat * dr));
+            cos_lat.push_back(std::cos(coords.lat * dr));
+            lng.push_back(coords.lng);
+        }
+
+        void Set(size_t index, Coordinates coords) {
+            static const double dr = M_PI / 180.;
+            sin_lat[index] = std::sin(coords.lat * dr);
+            cos_lat[index] = std::cos(coords.lat * dr);
+            lng[index] = coords.lng;
+        }
+
+        void Reserve(size_t count) {
+            sin_lat.reserve(count);
+            cos_lat.reserve(count);
+            lng.reserve(count);
+        }
+
+        size_t Size() const {
+            return lng.size();
+        }
+    };
+
+    // distance between points from and to of the table, from the stored trigonometry: bit-for-bit the value
+    // ComputeDistance gives for the original coordinates
+    inline double ComputeDistance(const CoordinatesTable& table, uint32_t from, uint32_t to) {
+        using namespace std;
+        static const double dr = M_PI / 180.;
+        if (table.sin_lat[from] == table.sin_lat[to] && table.cos_lat[from] == table.cos_lat[to] && table.lng[from] == table.lng[to]) {
+            return 0;
+        }
+        return acos(table.sin_lat[from] * table.sin_lat[to]
+            + table.cos_lat[from] * table.cos_lat[to] * cos(abs(table.lng[from] - table.lng[to]) * dr)) * EARTH_RADIUS;
+    }
+
+    // result[i] = distance between points from[i] and to[i] of the table; one pass, no buffers of its own
+    inline void ComputeDistances(const CoordinatesTable& table, const uint32_t* from, const uint32_t* to,
+        size_t count, double* result) {
+        for (size_t i = 0; i < count; ++i) {
+            result[i] = ComputeDistance(table, from[i], to[i]);
+        }
+    }
+}
\ No newline at end of file
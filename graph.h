@@ -2,6 +2,7 @@
 
 #include "ranges.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <vector>
 
@@ -27,6 +28,8 @@ namespace graph {
         DirectedWeightedGraph() = default;
         explicit DirectedWeightedGraph(size_t vertex_count);
         EdgeId AddEdge(const Edge<Weight>& edge);
+        void SetEdgeWeight(EdgeId edge_id, Weight weight);
+        void DetachEdge(EdgeId edge_id); // drops the edge from its vertex, the ID stays taken
 
         size_t GetVertexCount() const;
         size_t GetEdgeCount() const;
@@ -51,6 +54,17 @@ namespace graph {
         return id;
     }
 
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, Weight weight) {
+        edges_.at(edge_id).weight = weight;
+    }
+
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::DetachEdge(EdgeId edge_id) {
+        auto& incidence_list = incidence_lists_.at(edges_.at(edge_id).from);
+        incidence_list.erase(std::remove(incidence_list.begin(), incidence_list.end(), edge_id), incidence_list.end());
+    }
+
     template <typename Weight>
     size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
         return incidence_lists_.size();
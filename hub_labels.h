@@ -0,0 +1,270 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Route queries by label intersection. Every vertex keeps an out-label (hubs it reaches, with distances)
+    // and an in-label (hubs reaching it); the shortest route from s to t passes the common hub minimizing
+    // out(s) + in(t). Labels come from pruned landmark labeling: one Dijkstra per vertex in order of
+    // importance, cut wherever the labels built so far already give the distance. Each entry also keeps the
+    // edge toward its hub, so the route itself is recovered hop by hop from the labels along it.
+    template <typename Weight>
+    class HubLabels {
+    public:
+        using RouteInfo = typename Router<Weight>::RouteInfo;
+        static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+        struct LabelEntry {
+            uint32_t hub;  // rank of the hub vertex, entries are sorted by it
+            Weight weight;
+            EdgeId edge;   // out-labels: the first edge toward the hub, in-labels: the last edge from it
+        };
+
+        // labels of all vertices laid out flat: the entries of vertex v are [offsets[v], offsets[v + 1])
+        struct Labels {
+            std::vector<VertexId> vertex_by_rank;
+            std::vector<size_t> out_offsets;
+            std::vector<LabelEntry> out_entries;
+            std::vector<size_t> in_offsets;
+            std::vector<LabelEntry> in_entries;
+        };
+
+        explicit HubLabels(const DirectedWeightedGraph<Weight>& graph);
+        // the labels of other over graph, a copy of its graph
+        HubLabels(const DirectedWeightedGraph<Weight>& graph, const HubLabels& other)
+            : graph_(graph)
+            , labels_(other.labels_) {
+        }
+
+        /* for serialization */
+        template <typename LabelsType>
+        HubLabels(const DirectedWeightedGraph<Weight>& graph, LabelsType&& labels)
+            : graph_(graph)
+            , labels_(std::forward<LabelsType>(labels)) {
+        }
+
+        const Labels& GetLabels() const {
+            return labels_;
+        }
+        /* ------------------ */
+
+        std::optional<Weight> GetDistance(VertexId from, VertexId to) const;
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+        // relabels the whole graph after edges were changed, added or removed
+        void Rebuild();
+
+    private:
+        using LabelRange = std::pair<const LabelEntry*, const LabelEntry*>;
+        static constexpr Weight ZERO_WEIGHT{};
+
+        const DirectedWeightedGraph<Weight>& graph_;
+        Labels labels_;
+
+        LabelRange GetOutLabel(VertexId vertex) const {
+            return { labels_.out_entries.data() + labels_.out_offsets[vertex], labels_.out_entries.data() + labels_.out_offsets[vertex + 1] };
+        }
+        LabelRange GetInLabel(VertexId vertex) const {
+            return { labels_.in_entries.data() + labels_.in_offsets[vertex], labels_.in_entries.data() + labels_.in_offsets[vertex + 1] };
+        }
+        static const LabelEntry& FindHub(LabelRange label, uint32_t hub);
+        // the best common hub of out(from) and in(to): its entries in both labels
+        std::optional<std::pair<const LabelEntry*, const LabelEntry*>> FindBestHub(VertexId from, VertexId to) const;
+    };
+
+    template <typename Weight>
+    HubLabels<Weight>::HubLabels(const DirectedWeightedGraph<Weight>& graph)
+        : graph_(graph) {
+        Rebuild();
+    }
+
+    template <typename Weight>
+    void HubLabels<Weight>::Rebuild() {
+        const size_t vertex_count = graph_.GetVertexCount();
+        std::vector<std::vector<EdgeId>> incoming_edges(vertex_count);
+        std::vector<size_t> degree(vertex_count, 0);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                if (edge.weight < ZERO_WEIGHT) {
+                    throw std::domain_error("Edges' weights should be non-negative");
+                }
+                incoming_edges[edge.to].push_back(edge_id);
+                ++degree[edge.from];
+                ++degree[edge.to];
+            }
+        }
+
+        // well-connected stops first: they cover the most routes and keep the later searches short
+        labels_.vertex_by_rank.resize(vertex_count);
+        std::iota(labels_.vertex_by_rank.begin(), labels_.vertex_by_rank.end(), VertexId{ 0 });
+        std::stable_sort(labels_.vertex_by_rank.begin(), labels_.vertex_by_rank.end(),
+            [&degree](VertexId lhs, VertexId rhs) { return degree[lhs] > degree[rhs]; });
+
+        std::vector<std::vector<LabelEntry>> out_labels(vertex_count);
+        std::vector<std::vector<LabelEntry>> in_labels(vertex_count);
+        const Weight unreached = std::numeric_limits<Weight>::max();
+        std::vector<Weight> hub_distance(vertex_count, unreached); // by rank, the label of the current hub
+        std::vector<Weight> distance(vertex_count, unreached);
+        std::vector<EdgeId> edge_by_vertex(vertex_count, NO_EDGE);
+        std::vector<VertexId> visited;
+
+        // forward from the hub fills in-labels, backward fills out-labels
+        auto pruned_search = [&](uint32_t rank, bool reverse) {
+            const VertexId hub = labels_.vertex_by_rank[rank];
+            for (const LabelEntry& entry : reverse ? in_labels[hub] : out_labels[hub]) {
+                hub_distance[entry.hub] = entry.weight;
+            }
+
+            using Item = std::pair<Weight, VertexId>;
+            std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+            distance[hub] = ZERO_WEIGHT;
+            visited.push_back(hub);
+            queue.push({ ZERO_WEIGHT, hub });
+            while (!queue.empty()) {
+                const auto [weight, vertex] = queue.top();
+                queue.pop();
+                if (weight > distance[vertex]) {
+                    continue;
+                }
+                // covered by an earlier hub: neither the vertex nor anything behind it needs this one
+                bool is_covered = false;
+                for (const LabelEntry& entry : reverse ? out_labels[vertex] : in_labels[vertex]) {
+                    if (hub_distance[entry.hub] != unreached && hub_distance[entry.hub] + entry.weight <= weight) {
+                        is_covered = true;
+                        break;
+                    }
+                }
+                if (is_covered) {
+                    continue;
+                }
+                (reverse ? out_labels : in_labels)[vertex].push_back({ rank, weight, edge_by_vertex[vertex] });
+
+                auto relax = [&](EdgeId edge_id) {
+                    const auto& edge = graph_.GetEdge(edge_id);
+                    const VertexId next = reverse ? edge.from : edge.to;
+                    if (weight + edge.weight < distance[next]) {
+                        if (distance[next] == unreached) {
+                            visited.push_back(next);
+                        }
+                        distance[next] = weight + edge.weight;
+                        edge_by_vertex[next] = edge_id;
+                        queue.push({ distance[next], next });
+                    }
+                };
+                if (reverse) {
+                    std::for_each(incoming_edges[vertex].begin(), incoming_edges[vertex].end(), relax);
+                }
+                else {
+                    for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                        relax(edge_id);
+                    }
+                }
+            }
+
+            for (VertexId vertex : visited) {
+                distance[vertex] = unreached;
+                edge_by_vertex[vertex] = NO_EDGE;
+            }
+            visited.clear();
+            for (const LabelEntry& entry : reverse ? in_labels[hub] : out_labels[hub]) {
+                hub_distance[entry.hub] = unreached;
+            }
+        };
+
+        for (uint32_t rank = 0; rank < vertex_count; ++rank) {
+            pruned_search(rank, false);
+            pruned_search(rank, true);
+        }
+
+        auto flatten = [vertex_count](std::vector<std::vector<LabelEntry>>& labels, std::vector<size_t>& offsets,
+            std::vector<LabelEntry>& entries) {
+            offsets.assign(1, 0);
+            entries.clear();
+            for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+                entries.insert(entries.end(), labels[vertex].begin(), labels[vertex].end());
+                offsets.push_back(entries.size());
+                std::vector<LabelEntry>().swap(labels[vertex]);
+            }
+        };
+        flatten(out_labels, labels_.out_offsets, labels_.out_entries);
+        flatten(in_labels, labels_.in_offsets, labels_.in_entries);
+    }
+
+    template <typename Weight>
+    const typename HubLabels<Weight>::LabelEntry& HubLabels<Weight>::FindHub(LabelRange label, uint32_t hub) {
+        return *std::lower_bound(label.first, label.second, hub,
+            [](const LabelEntry& entry, uint32_t value) { return entry.hub < value; });
+    }
+
+    template <typename Weight>
+    std::optional<std::pair<const typename HubLabels<Weight>::LabelEntry*, const typename HubLabels<Weight>::LabelEntry*>>
+        HubLabels<Weight>::FindBestHub(VertexId from, VertexId to) const {
+        auto [out, out_end] = GetOutLabel(from);
+        auto [in, in_end] = GetInLabel(to);
+        std::optional<std::pair<const LabelEntry*, const LabelEntry*>> best;
+        while (out != out_end && in != in_end) {
+            if (out->hub < in->hub) {
+                ++out;
+            }
+            else if (in->hub < out->hub) {
+                ++in;
+            }
+            else {
+                if (!best || out->weight + in->weight < best->first->weight + best->second->weight) {
+                    best = { out, in };
+                }
+                ++out;
+                ++in;
+            }
+        }
+        return best;
+    }
+
+    template <typename Weight>
+    std::optional<Weight> HubLabels<Weight>::GetDistance(VertexId from, VertexId to) const {
+        const auto best = FindBestHub(from, to);
+        if (!best) {
+            return std::nullopt;
+        }
+        return best->first->weight + best->second->weight;
+    }
+
+    template <typename Weight>
+    std::optional<typename HubLabels<Weight>::RouteInfo> HubLabels<Weight>::BuildRoute(VertexId from, VertexId to) const {
+        const auto best = FindBestHub(from, to);
+        if (!best) {
+            return std::nullopt;
+        }
+        const uint32_t hub = best->first->hub;
+
+        // every vertex on a hub's search tree carries the hub in its label, so the chain never breaks
+        std::vector<EdgeId> edges;
+        for (const LabelEntry* entry = best->first; entry->edge != NO_EDGE;) {
+            edges.push_back(entry->edge);
+            entry = &FindHub(GetOutLabel(graph_.GetEdge(entry->edge).to), hub);
+        }
+        const size_t to_hub = edges.size();
+        for (const LabelEntry* entry = best->second; entry->edge != NO_EDGE;) {
+            edges.push_back(entry->edge);
+            entry = &FindHub(GetInLabel(graph_.GetEdge(entry->edge).from), hub);
+        }
+        std::reverse(edges.begin() + to_hub, edges.end());
+
+        return RouteInfo{ best->first->weight + best->second->weight, std::move(edges) };
+    }
+
+}  // namespace graph
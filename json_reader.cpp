@@ -3,6 +3,8 @@
 #include <sstream>
 #include <algorithm>
 #include <exception>
+#include <map>
+#include <stdexcept>
 
 namespace transport_catalogue {
 
@@ -19,17 +21,17 @@ namespace transport_catalogue {
 				return { json_stop.at("name"s).AsString(), { json_stop.at("latitude"s).AsDouble(), json_stop.at("longitude"s).AsDouble()} };
 			}
 
-			domain::Bus BuildBusFromJSON(const json::Dict& json_bus, const TransportCatalogue& catalogue) {
-				json::Array stops = json_bus.at("stops"s).AsArray();
-				std::vector<const domain::Stop*> route;
+			std::vector<uint32_t> BuildRouteFromJSON(const json::Dict& json_bus, const TransportCatalogue& catalogue) {
+				const json::Array& stops = json_bus.at("stops"s).AsArray();
+				std::vector<uint32_t> route;
 				route.reserve(stops.size());
 				for (const json::Node& stop : stops) {
-					route.push_back(catalogue.FindStopByName(stop.AsString()).value());
+					route.push_back(static_cast<uint32_t>(catalogue.FindStopByName(stop.AsString()).value()->id));
 				}
-				return { json_bus.at("name"s).AsString(), route, json_bus.at("is_roundtrip"s).AsBool() };
+				return route;
 			}
 
-			json::Dict TransformStopInfoToJSON(const std::optional<std::set<std::string_view>>& buses_by_stop, int id) { //rewrite with Builder
+			json::Dict TransformStopInfoToJSON(const std::optional<StopBusesView>& buses_by_stop, int id) { //rewrite with Builder
 				if (!buses_by_stop) {
 					return json::Builder{}.StartDict().
 						Key("error_message"s).Value("not found"s).
@@ -87,12 +89,46 @@ namespace transport_catalogue {
 				return color;
 			}
 
-			json::Dict TransformMapToJSON(const std::string& map, int id) { //rewrite with Builder
-				return json::Builder{}.StartDict().Key("map"s).Value(map).Key("request_id"s).Value(id).EndDict().Build().AsMap();
+			json::Dict TransformNearestStopsToJSON(const std::vector<StopDistance>& stops, int id) {
+				auto builder = json::Builder{};
+				auto answer = builder.StartDict().Key("stops"s).StartArray();
+				for (const StopDistance& item : stops) {
+					answer.StartDict().
+						Key("name"s).Value(std::string(item.stop->stop)).
+						Key("distance"s).Value(item.distance).EndDict();
+				}
+				return answer.EndArray().Key("request_id"s).Value(id).EndDict().Build().AsMap();
 			}
 
-			json::Dict TransformRouteInfoToJSON(const std::optional<TransportRouter::TransportRouteInfo>& route_info, int id) {
-				if (!route_info) {
+			json::Dict TransformStopsInAreaToJSON(const std::vector<const domain::Stop*>& stops, int id) {
+				auto builder = json::Builder{};
+				auto answer = builder.StartDict().Key("stops"s).StartArray();
+				for (const domain::Stop* stop : stops) {
+					answer.Value(std::string(stop->stop));
+				}
+				return answer.EndArray().Key("request_id"s).Value(id).EndDict().Build().AsMap();
+			}
+
+			json::Dict TransformRouteMatrixToJSON(const std::vector<std::vector<std::optional<double>>>& times, int id) {
+				auto builder = json::Builder{};
+				auto answer = builder.StartDict().Key("times"s).StartArray();
+				for (const auto& row : times) {
+					auto json_row = answer.StartArray();
+					for (const std::optional<double>& time : row) {
+						if (time) {
+							json_row.Value(*time);
+						}
+						else {
+							json_row.Value(nullptr);
+						}
+					}
+					json_row.EndArray();
+				}
+				return answer.EndArray().Key("request_id"s).Value(id).EndDict().Build().AsMap();
+			}
+
+			json::Dict TransformIsochroneToJSON(const std::optional<std::vector<TransportRouter::ReachableStop>>& stops, int id) {
+				if (!stops) {
 					return json::Builder{}.StartDict().
 						Key("error_message"s).Value("not found"s).
 						Key("request_id"s).Value(id).
@@ -100,8 +136,23 @@ namespace transport_catalogue {
 				}
 
 				auto builder = json::Builder{};
-				auto answer = builder.StartDict().Key("items"s).StartArray();
-				for (auto segment : route_info->segments) {
+				auto answer = builder.StartDict().Key("stops"s).StartArray();
+				for (const TransportRouter::ReachableStop& item : *stops) {
+					answer.StartDict().
+						Key("name"s).Value(std::string(item.stop)).
+						Key("time"s).Value(item.time).EndDict();
+				}
+				return answer.EndArray().Key("request_id"s).Value(id).EndDict().Build().AsMap();
+			}
+
+			json::Dict TransformMapToJSON(const std::string& map, int id) { //rewrite with Builder
+				return json::Builder{}.StartDict().Key("map"s).Value(map).Key("request_id"s).Value(id).EndDict().Build().AsMap();
+			}
+
+			json::Array TransformRouteItemsToJSON(const std::vector<const RouteSegment*>& segments) {
+				auto builder = json::Builder{};
+				auto answer = builder.StartArray();
+				for (auto segment : segments) {
 					if (segment->type == RouteSegment::Type::WAIT) {
 						answer.StartDict().
 							Key("type"s).Value("Wait"s).
@@ -116,11 +167,63 @@ namespace transport_catalogue {
 							Key("time"s).Value(segment->time).EndDict();
 					}
 				}
-				return answer.EndArray().
+				return answer.EndArray().Build().AsArray();
+			}
+
+			json::Dict TransformRouteInfoToJSON(const std::optional<TransportRouter::TransportRouteInfo>& route_info, int id) {
+				if (!route_info) {
+					return json::Builder{}.StartDict().
+						Key("error_message"s).Value("not found"s).
+						Key("request_id"s).Value(id).
+						EndDict().Build().AsMap();
+				}
+
+				return json::Builder{}.StartDict().
+					Key("items"s).Value(TransformRouteItemsToJSON(route_info->segments)).
 					Key("request_id"s).Value(id).
 					Key("total_time"s).Value(route_info->weight).
 					EndDict().Build().AsMap();
 			}
+
+			json::Dict TransformTimetableRouteToJSON(const std::optional<TimetableRouter::Journey>& journey, int id) {
+				if (!journey) {
+					return json::Builder{}.StartDict().
+						Key("error_message"s).Value("not found"s).
+						Key("request_id"s).Value(id).
+						EndDict().Build().AsMap();
+				}
+
+				std::vector<const RouteSegment*> segments;
+				segments.reserve(journey->segments.size());
+				for (const RouteSegment& segment : journey->segments) {
+					segments.push_back(&segment);
+				}
+				return json::Builder{}.StartDict().
+					Key("arrival_time"s).Value(journey->arrival).
+					Key("items"s).Value(TransformRouteItemsToJSON(segments)).
+					Key("request_id"s).Value(id).
+					Key("total_time"s).Value(journey->arrival - journey->departure).
+					EndDict().Build().AsMap();
+			}
+
+			json::Dict TransformRouteOptionsToJSON(const std::optional<std::vector<TransportRouter::RouteOption>>& options, int id) {
+				if (!options) {
+					return json::Builder{}.StartDict().
+						Key("error_message"s).Value("not found"s).
+						Key("request_id"s).Value(id).
+						EndDict().Build().AsMap();
+				}
+
+				auto builder = json::Builder{};
+				auto answer = builder.StartDict().Key("options"s).StartArray();
+				for (const TransportRouter::RouteOption& option : *options) {
+					answer.StartDict().
+						Key("items"s).Value(TransformRouteItemsToJSON(option.route.segments)).
+						Key("total_time"s).Value(option.route.weight).
+						Key("transfers"s).Value(static_cast<int>(option.transfers)).EndDict();
+				}
+				return answer.EndArray().Key("request_id"s).Value(id).EndDict().Build().AsMap();
+			}
 		}
 
 		/* JSONReader - PUBLIC */
@@ -159,24 +262,55 @@ namespace transport_catalogue {
 			using namespace detail;
 			auto builder = json::Builder{};
 			auto answers = builder.StartArray();
+			const auto snapshot = handler_.Pin(); // one version for the whole batch
+
+			// isochrones are independent searches, the whole batch runs up front
+			std::vector<const RequestHandler::Query*> isochrone_queries;
+			for (const RequestHandler::Query& query : handler_.GetRequests()) {
+				if (query.type == RequestHandler::Query::Type::ISOCHRONE) {
+					isochrone_queries.push_back(&query);
+				}
+			}
+			const auto isochrones = isochrone_queries.empty()
+				? std::vector<std::optional<std::vector<TransportRouter::ReachableStop>>>{}
+				: handler_.IsochroneRequests(*snapshot, isochrone_queries);
+			size_t next_isochrone = 0;
 
 			for (const RequestHandler::Query& query : handler_.GetRequests()) {
 				json::Dict ans;
 				if (query.type == RequestHandler::Query::Type::STOP) {
-					auto opt = handler_.InfoStopRequest(query);
+					auto opt = handler_.InfoStopRequest(*snapshot, query);
 					ans = TransformStopInfoToJSON(opt, query.id);
 				}
 				else if (query.type == RequestHandler::Query::Type::BUS) {
-					auto opt = handler_.InfoBusRequest(query);
+					auto opt = handler_.InfoBusRequest(*snapshot, query);
 					ans = TransformBusInfoToJSON(opt, query.id);
 				}
 				else if (query.type == RequestHandler::Query::Type::ROUTE) {
-					auto opt = handler_.GetShortestRouteRequest(query);
+					auto opt = handler_.GetShortestRouteRequest(*snapshot, query);
 					ans = TransformRouteInfoToJSON(opt, query.id);
 				}
+				else if (query.type == RequestHandler::Query::Type::TIMETABLE_ROUTE) {
+					ans = TransformTimetableRouteToJSON(handler_.TimetableRouteRequest(*snapshot, query), query.id);
+				}
+				else if (query.type == RequestHandler::Query::Type::ROUTE_OPTIONS) {
+					ans = TransformRouteOptionsToJSON(handler_.RouteOptionsRequest(*snapshot, query), query.id);
+				}
+				else if (query.type == RequestHandler::Query::Type::ROUTE_MATRIX) {
+					ans = TransformRouteMatrixToJSON(handler_.RouteMatrixRequest(*snapshot, query), query.id);
+				}
+				else if (query.type == RequestHandler::Query::Type::ISOCHRONE) {
+					ans = TransformIsochroneToJSON(isochrones[next_isochrone++], query.id);
+				}
+				else if (query.type == RequestHandler::Query::Type::NEAREST_STOPS) {
+					ans = TransformNearestStopsToJSON(handler_.NearestStopsRequest(*snapshot, query), query.id);
+				}
+				else if (query.type == RequestHandler::Query::Type::STOPS_IN_AREA) {
+					ans = TransformStopsInAreaToJSON(handler_.StopsInAreaRequest(*snapshot, query), query.id);
+				}
 				else if (query.type == RequestHandler::Query::Type::MAP) {
 					std::ostringstream stream;
-					handler_.DrawMapRequest(stream);
+					handler_.DrawMapRequest(*snapshot, stream);
 					ans = TransformMapToJSON(stream.str(), query.id);
 				}
 				else {
@@ -204,9 +338,10 @@ namespace transport_catalogue {
 
 
 		/* JSONReader - PRIVATE */
-		void JSONReader::SetDistancesFromJSON(std::string_view from, const json::Dict& distances) {
-			for (auto [to, json_distance] : distances) {
-				catalogue_.SetDistance(from, to, static_cast<size_t>(json_distance.AsInt()));
+		void JSONReader::SetDistancesFromJSON(TransportCatalogue::BulkLoader& loader, std::string_view from, const json::Dict& distances) {
+			const size_t from_id = catalogue_.FindStopByName(from).value()->id;
+			for (const auto& [to, json_distance] : distances) {
+				loader.AddDistance(from_id, catalogue_.FindStopByName(to).value()->id, static_cast<size_t>(json_distance.AsInt()));
 			}
 		}
 
@@ -218,14 +353,30 @@ namespace transport_catalogue {
 					return CheckNodeType(left, "Stop"sv) && CheckNodeType(right, "Bus"sv);
 				});
 
+			size_t stop_count = 0;
+			size_t route_stop_count = 0;
+			size_t distance_count = 0;
 			for (const json::Node& query : query_queue) {
 				if (CheckNodeType(query, "Stop"sv)) {
-					domain::Stop stop = BuildStopFromJSON(query.AsMap());
-					catalogue_.AddStop(stop);
+					++stop_count;
+					distance_count += query.AsMap().at("road_distances"s).AsMap().size();
 				}
 				else {
-					domain::Bus bus = BuildBusFromJSON(query.AsMap(), catalogue_);
-					catalogue_.AddBus(bus);
+					route_stop_count += query.AsMap().at("stops"s).AsArray().size();
+				}
+			}
+
+			TransportCatalogue::BulkLoader loader(catalogue_);
+			loader.Reserve(stop_count, query_queue.size() - stop_count, route_stop_count, distance_count);
+
+			for (const json::Node& query : query_queue) {
+				if (CheckNodeType(query, "Stop"sv)) {
+					loader.AddStop(BuildStopFromJSON(query.AsMap()));
+				}
+				else {
+					loader.AddBus(query.AsMap().at("name"s).AsString(),
+						BuildRouteFromJSON(query.AsMap(), catalogue_),
+						query.AsMap().at("is_roundtrip"s).AsBool());
 				}
 			}
 
@@ -234,9 +385,25 @@ namespace transport_catalogue {
 					break;
 				}
 				else {
-					SetDistancesFromJSON(query.AsMap().at("name"s).AsString(), query.AsMap().at("road_distances"s).AsMap());
+					SetDistancesFromJSON(loader, query.AsMap().at("name"s).AsString(), query.AsMap().at("road_distances"s).AsMap());
+				}
+			}
+
+			loader.Finalize();
+
+			// trips of the buses that have a timetable, keyed by the names the catalogue holds
+			Timetable timetable;
+			for (const json::Node& query : query_queue) {
+				if (CheckNodeType(query, "Bus"sv) && query.AsMap().count("departures"s) > 0) {
+					std::vector<double>& departures = timetable[catalogue_.FindBusByName(query.AsMap().at("name"s).AsString()).value()->bus];
+					for (const json::Node& departure : query.AsMap().at("departures"s).AsArray()) {
+						departures.push_back(departure.AsDouble());
+					}
 				}
 			}
+			if (!timetable.empty()) {
+				handler_.SetTimetable(std::move(timetable));
+			}
 		}
 
 		void JSONReader::AddRequestsToHandlerFromJSON(const json::Array& query_queue) {
@@ -245,6 +412,8 @@ namespace transport_catalogue {
 			for (const json::Node& query : query_queue) {
 				RequestHandler::Query::Type type;
 				std::vector<std::string> parameters;
+				std::vector<double> values;
+				std::vector<size_t> counts;
 
 				if (CheckNodeType(query, "Stop"sv)) {
 					type = RequestHandler::Query::Type::STOP;
@@ -258,6 +427,50 @@ namespace transport_catalogue {
 					type = RequestHandler::Query::Type::ROUTE;
 					parameters.push_back(query.AsMap().at("from"s).AsString());
 					parameters.push_back(query.AsMap().at("to"s).AsString());
+					// a departure time asks for the earliest arrival by the timetable
+					if (query.AsMap().count("departure_time"s) > 0) {
+						type = RequestHandler::Query::Type::TIMETABLE_ROUTE;
+						values.push_back(query.AsMap().at("departure_time"s).AsDouble());
+					}
+				}
+				else if (CheckNodeType(query, "RouteOptions"sv)) {
+					type = RequestHandler::Query::Type::ROUTE_OPTIONS;
+					parameters.push_back(query.AsMap().at("from"s).AsString());
+					parameters.push_back(query.AsMap().at("to"s).AsString());
+				}
+				else if (CheckNodeType(query, "RouteMatrix"sv)) {
+					type = RequestHandler::Query::Type::ROUTE_MATRIX;
+					const json::Array& from = query.AsMap().at("from"s).AsArray();
+					const json::Array& to = query.AsMap().at("to"s).AsArray();
+					for (const json::Node& stop : from) {
+						parameters.push_back(stop.AsString());
+					}
+					for (const json::Node& stop : to) {
+						parameters.push_back(stop.AsString());
+					}
+					counts.push_back(from.size());
+				}
+				else if (CheckNodeType(query, "Isochrone"sv)) {
+					type = RequestHandler::Query::Type::ISOCHRONE;
+					parameters.push_back(query.AsMap().at("from"s).AsString());
+					values.push_back(query.AsMap().at("max_time"s).AsDouble());
+				}
+				else if (CheckNodeType(query, "NearestStops"sv)) {
+					type = RequestHandler::Query::Type::NEAREST_STOPS;
+					values.push_back(query.AsMap().at("latitude"s).AsDouble());
+					values.push_back(query.AsMap().at("longitude"s).AsDouble());
+					const int count = query.AsMap().at("count"s).AsInt();
+					if (count < 0) {
+						throw std::invalid_argument("NearestStops count should be non-negative: "s + std::to_string(count));
+					}
+					counts.push_back(static_cast<size_t>(count));
+				}
+				else if (CheckNodeType(query, "StopsInArea"sv)) {
+					type = RequestHandler::Query::Type::STOPS_IN_AREA;
+					values.push_back(query.AsMap().at("min_latitude"s).AsDouble());
+					values.push_back(query.AsMap().at("min_longitude"s).AsDouble());
+					values.push_back(query.AsMap().at("max_latitude"s).AsDouble());
+					values.push_back(query.AsMap().at("max_longitude"s).AsDouble());
 				}
 				else if (CheckNodeType(query, "Map"sv)) {
 					type = RequestHandler::Query::Type::MAP;
@@ -269,7 +482,9 @@ namespace transport_catalogue {
 				RequestHandler::Query formed_query{
 					query.AsMap().at("id"s).AsInt(),
 					type,
-					std::move(parameters)
+					std::move(parameters),
+					std::move(values),
+					std::move(counts)
 				};
 
 				handler_.AddRequest(std::move(formed_query));
@@ -314,12 +529,57 @@ namespace transport_catalogue {
 		}
 
 		void JSONReader::AddSettingsAndBuildRouterFromJSON(const json::Dict& json_settings) {
-			handler_.SetRouterSettings(
-				TransportGraph::Settings{
-					json_settings.at("bus_wait_time"s).AsInt(),
-					json_settings.at("bus_velocity"s).AsDouble()
+			TransportGraph::Settings settings{
+				json_settings.at("bus_wait_time"s).AsInt(),
+				json_settings.at("bus_velocity"s).AsDouble()
+			};
+			if (auto it = json_settings.find("engine"s); it != json_settings.end()) {
+				const std::string& engine = it->second.AsString();
+				if (engine == "alt"s) {
+					settings.engine = RouteEngine::ALT;
 				}
-			);
+				else if (engine == "hub_labels"s) {
+					settings.engine = RouteEngine::HUB_LABELS;
+				}
+				else if (engine == "raptor"s) {
+					settings.engine = RouteEngine::RAPTOR;
+				}
+				else if (engine != "table"s) {
+					throw std::invalid_argument("Unknown routing engine: "s + engine);
+				}
+			}
+			if (auto it = json_settings.find("vertex_order"s); it != json_settings.end()) {
+				const std::string& order = it->second.AsString();
+				if (order == "catalogue"s) {
+					settings.vertex_order = VertexOrder::CATALOGUE;
+				}
+				else if (order != "hilbert"s) {
+					throw std::invalid_argument("Unknown vertex order: "s + order);
+				}
+			}
+			if (auto it = json_settings.find("landmark_count"s); it != json_settings.end()) {
+				settings.landmark_count = static_cast<size_t>(it->second.AsInt());
+			}
+			if (auto it = json_settings.find("tree_cache_size"s); it != json_settings.end()) {
+				settings.tree_cache_size = static_cast<size_t>(it->second.AsInt());
+			}
+			if (auto it = json_settings.find("max_router_memory_mb"s); it != json_settings.end()) {
+				settings.max_router_memory_mb = static_cast<size_t>(it->second.AsInt());
+			}
+			// origins of past queries, repeated as often as they were asked for
+			if (auto it = json_settings.find("query_log"s); it != json_settings.end()) {
+				std::map<std::string, size_t> query_count;
+				for (const json::Node& stop : it->second.AsArray()) {
+					++query_count[stop.AsString()];
+				}
+				std::vector<std::pair<std::string, size_t>> ranked(query_count.begin(), query_count.end());
+				std::stable_sort(ranked.begin(), ranked.end(),
+					[](const auto& lhs, const auto& rhs) { return lhs.second > rhs.second; });
+				for (auto& [stop, count] : ranked) {
+					settings.frequent_stops.push_back(std::move(stop));
+				}
+			}
+			handler_.SetRouterSettings(std::move(settings));
 		}
 
 		void JSONReader::AddSerializationFile(const json::Dict& serialization_settings) {
@@ -25,7 +25,7 @@ namespace transport_catalogue {
 			RequestHandler handler_; //create on base of catalogue
 			std::filesystem::path serialization_file_;
 
-			void SetDistancesFromJSON(std::string_view from, const json::Dict& distances);
+			void SetDistancesFromJSON(TransportCatalogue::BulkLoader& loader, std::string_view from, const json::Dict& distances);
 			void AddDataToCatalogueFromJSON(json::Array& query_queue);
 			void AddRequestsToHandlerFromJSON(const json::Array& query_queue);
 			void AddSettingsToRendererFromJSON(const json::Dict& json_settings);
@@ -1,15 +1,23 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
 #include <string_view>
+#include <vector>
 
 #include "transport_catalogue.h"
 #include "json_reader.h"
 #include "serialization.h"
+#include "tests.h"
 
 using namespace std::literals;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base|process_requests|benchmark_router|benchmark_updates|benchmark_catalogue|test]\n"sv;
 }
 
 void RunMakeBase() {
@@ -38,7 +46,332 @@ void RunProcessRequests() {
     reader.PrintAnswers(std::cout);
 }
 
+// plain Dijkstra against the landmark search, the hub labels and RAPTOR on random stop pairs of the network given
+// as a make_base document: preprocessing, settled vertices or label sizes, time per query, and any
+// disagreement in the route times. Then the shortest path tree cache on origins skewed toward a few hubs, and
+// the vertex order against the catalogue one
+void RunRouterBenchmark() {
+    constexpr size_t QUERY_COUNT = 1000;
+    transport_catalogue::TransportCatalogue catalogue;
+    transport_catalogue::interfaces::JSONReader reader(catalogue);
+    reader.LoadData(std::cin);
+    const auto& transport_graph = reader.GetHandler().GetRouter().GetTransportGraph();
+    const auto& graph = transport_graph.GetInnerGraph();
+    if (graph.GetVertexCount() == 0) {
+        std::cerr << "No stops\n"sv;
+        return;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const auto preprocessing_start = Clock::now();
+    const graph::AltRouter<transport_catalogue::RouteWeight> alt_router(graph, transport_graph.GetSettings().landmark_count);
+    const std::chrono::duration<double, std::milli> preprocessing = Clock::now() - preprocessing_start;
+    const auto labeling_start = Clock::now();
+    const graph::HubLabels<transport_catalogue::RouteWeight> hub_labels(graph);
+    const std::chrono::duration<double, std::milli> labeling = Clock::now() - labeling_start;
+    const transport_catalogue::RaptorRouter raptor_router(catalogue, transport_graph);
+    const auto& labels = hub_labels.GetLabels();
+    const size_t label_entries = labels.out_entries.size() + labels.in_entries.size();
+
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<graph::VertexId> vertex(0, graph.GetVertexCount() - 1);
+    graph::SearchStats dijkstra_stats;
+    graph::SearchStats alt_stats;
+    std::chrono::duration<double, std::micro> dijkstra_time{};
+    std::chrono::duration<double, std::micro> alt_time{};
+    std::chrono::duration<double, std::micro> labels_time{};
+    std::chrono::duration<double, std::micro> raptor_time{};
+    size_t mismatches = 0;
+    for (size_t query = 0; query < QUERY_COUNT; ++query) {
+        const graph::VertexId from = vertex(generator);
+        const graph::VertexId to = vertex(generator);
+
+        auto start = Clock::now();
+        const auto expected = graph::FindDistance(graph, from, to, &dijkstra_stats);
+        dijkstra_time += Clock::now() - start;
+
+        start = Clock::now();
+        const auto route = alt_router.BuildRoute(from, to, &alt_stats);
+        alt_time += Clock::now() - start;
+
+        start = Clock::now();
+        const auto labeled_route = hub_labels.BuildRoute(from, to);
+        labels_time += Clock::now() - start;
+
+        start = Clock::now();
+        const auto journeys = raptor_router.FindJourneys(from, to);
+        raptor_time += Clock::now() - start;
+        const auto raptor_route = journeys.empty()
+            ? std::nullopt
+            : std::optional<graph::Router<transport_catalogue::RouteWeight>::RouteInfo>({ journeys.back().weight, journeys.back().edges });
+
+        for (const auto& found : { route, labeled_route, raptor_route }) {
+            if (expected.has_value() != found.has_value() || (found && std::abs(found->weight - *expected) > 1e-6)) {
+                ++mismatches;
+            }
+        }
+    }
+
+    std::cout << "stops: "sv << graph.GetVertexCount() << ", edges: "sv << graph.GetEdgeCount()
+        << ", landmarks: "sv << alt_router.GetLandmarks().vertices.size()
+        << " (preprocessing "sv << preprocessing.count() << " ms)\n"sv;
+    std::cout << "dijkstra: "sv << dijkstra_stats.settled / QUERY_COUNT << " settled, "sv
+        << dijkstra_time.count() / QUERY_COUNT << " us per query\n"sv;
+    std::cout << "alt: "sv << alt_stats.settled / QUERY_COUNT << " settled, "sv
+        << alt_time.count() / QUERY_COUNT << " us per query\n"sv;
+    std::cout << "hub labels: "sv << label_entries / graph.GetVertexCount() << " entries per stop ("sv
+        << label_entries * sizeof(graph::HubLabels<transport_catalogue::RouteWeight>::LabelEntry) / 1024 << " KiB, labeling "sv
+        << labeling.count() << " ms), "sv << labels_time.count() / QUERY_COUNT << " us per query\n"sv;
+    std::cout << "raptor: "sv << raptor_time.count() / QUERY_COUNT << " us per query\n"sv;
+
+    // nine queries in ten start at one of the hubs, as in real traffic
+    constexpr size_t HUB_COUNT = 100;
+    const size_t cache_size = transport_graph.GetSettings().tree_cache_size > 0
+        ? transport_graph.GetSettings().tree_cache_size : HUB_COUNT;
+    const graph::ShortestPathTreeCache<transport_catalogue::RouteWeight> tree_cache(graph, cache_size);
+    std::vector<graph::VertexId> hubs(HUB_COUNT);
+    for (graph::VertexId& hub : hubs) {
+        hub = vertex(generator);
+    }
+    std::uniform_int_distribution<size_t> hub_index(0, HUB_COUNT - 1);
+    std::bernoulli_distribution from_hub(0.9);
+    std::chrono::duration<double, std::micro> cache_time{};
+    for (size_t query = 0; query < QUERY_COUNT; ++query) {
+        const graph::VertexId from = from_hub(generator) ? hubs[hub_index(generator)] : vertex(generator);
+        const graph::VertexId to = vertex(generator);
+
+        const auto start = Clock::now();
+        const auto cached_route = tree_cache.BuildRoute(from, to);
+        cache_time += Clock::now() - start;
+
+        const auto expected = hub_labels.GetDistance(from, to);
+        if (expected.has_value() != cached_route.has_value() || (cached_route && std::abs(cached_route->weight - *expected) > 1e-6)) {
+            ++mismatches;
+        }
+    }
+    const auto cache_stats = tree_cache.GetStats();
+    std::cout << "tree cache: "sv << cache_size << " trees, "sv << cache_stats.hits << " hits, "sv << cache_stats.misses
+        << " misses, "sv << cache_time.count() / QUERY_COUNT << " us per query\n"sv;
+    std::cout << "mismatches: "sv << mismatches << '\n';
+
+    // the same graph numbered as the catalogue lists the stops: full searches from the same origins on both,
+    // and the mean ID gap along an edge as the locality the caches see
+    std::vector<graph::VertexId> catalogue_id(graph.GetVertexCount());
+    for (graph::VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+        catalogue_id[vertex] = catalogue.FindStopByName(transport_graph.GetStopName(vertex)).value()->id;
+    }
+    graph::DirectedWeightedGraph<transport_catalogue::RouteWeight> catalogue_graph(graph.GetVertexCount());
+    double gap = 0.0;
+    double catalogue_gap = 0.0;
+    for (graph::EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        catalogue_graph.AddEdge({ catalogue_id[edge.from], catalogue_id[edge.to], edge.weight });
+        gap += std::abs(static_cast<double>(edge.from) - edge.to);
+        catalogue_gap += std::abs(static_cast<double>(catalogue_id[edge.from]) - catalogue_id[edge.to]);
+    }
+    constexpr size_t TREE_COUNT = 200;
+    std::chrono::duration<double, std::micro> tree_time{};
+    std::chrono::duration<double, std::micro> catalogue_tree_time{};
+    for (size_t query = 0; query < TREE_COUNT; ++query) {
+        const graph::VertexId from = vertex(generator);
+        auto start = Clock::now();
+        graph::BuildShortestPathTree(graph, from);
+        tree_time += Clock::now() - start;
+        start = Clock::now();
+        graph::BuildShortestPathTree(catalogue_graph, catalogue_id[from]);
+        catalogue_tree_time += Clock::now() - start;
+    }
+    const char* order = transport_graph.GetSettings().vertex_order == transport_catalogue::VertexOrder::HILBERT
+        ? "hilbert" : "catalogue";
+    std::cout << "vertex order "sv << order << ": mean edge gap "sv << gap / std::max<size_t>(graph.GetEdgeCount(), 1)
+        << ", "sv << tree_time.count() / TREE_COUNT << " us per full search; catalogue order: mean edge gap "sv
+        << catalogue_gap / std::max<size_t>(graph.GetEdgeCount(), 1) << ", "sv
+        << catalogue_tree_time.count() / TREE_COUNT << " us per full search\n"sv;
+}
+
+// one bus added and then one ride made faster on the network given as a make_base document: the route table
+// updated in place against a TransportRouter built from scratch, and the answers of both on random stop pairs
+void RunUpdateBenchmark() {
+    constexpr size_t PAIR_COUNT = 1000;
+    using namespace transport_catalogue;
+    TransportCatalogue catalogue;
+    interfaces::JSONReader reader(catalogue);
+    reader.LoadData(std::cin);
+    TransportGraph::Settings settings = reader.GetHandler().GetRouter().GetTransportGraph().GetSettings();
+    settings.engine = RouteEngine::TRANSFER_TABLE; // the full table is what the updates repair
+    settings.max_router_memory_mb = 0;
+
+    // the bus runs between two stops served by two buses already, so no new transfer stop appears
+    std::vector<const Stop*> transfers;
+    for (const Stop& stop : catalogue.GetAllStops()) {
+        const auto buses = catalogue.GetBusesByStop(stop.stop);
+        if (std::distance(buses->begin(), buses->end()) > 1) {
+            transfers.push_back(&stop);
+        }
+    }
+    if (transfers.size() < 2) {
+        std::cerr << "No transfer stops\n"sv;
+        return;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    std::mt19937 generator(36);
+    auto compare = [&](const TransportRouter& updated, const TransportRouter& rebuilt) {
+        const auto& stops = catalogue.GetAllStops();
+        std::uniform_int_distribution<size_t> stop(0, stops.size() - 1);
+        size_t mismatches = 0;
+        for (size_t i = 0; i < PAIR_COUNT; ++i) {
+            const std::string_view from = stops[stop(generator)].stop;
+            const std::string_view to = stops[stop(generator)].stop;
+            const auto route = updated.GetShortestRoute(from, to);
+            const auto expected = rebuilt.GetShortestRoute(from, to);
+            if (route.has_value() != expected.has_value()
+                || (route && std::abs(route->weight - expected->weight) > 1e-9 * std::max(1.0, expected->weight))) {
+                ++mismatches;
+            }
+        }
+        return mismatches;
+    };
+    auto report = [&](std::string_view change, TransportRouter& router, auto apply) {
+        const auto update_start = Clock::now();
+        apply(router);
+        const std::chrono::duration<double, std::milli> update_time = Clock::now() - update_start;
+        const auto rebuild_start = Clock::now();
+        const TransportRouter rebuilt(catalogue, settings);
+        const std::chrono::duration<double, std::milli> rebuild_time = Clock::now() - rebuild_start;
+        std::cout << change << ": "sv << update_time.count() << " ms in place, "sv << rebuild_time.count()
+            << " ms from scratch; "sv << compare(router, rebuilt) << " of "sv << PAIR_COUNT << " answers differ\n"sv;
+    };
+
+    TransportRouter router(catalogue, settings);
+    std::uniform_int_distribution<size_t> transfer(0, transfers.size() - 1);
+    const Stop* from = transfers[transfer(generator)];
+    const Stop* to = transfers[transfer(generator)];
+    const auto& distances = catalogue.GetAllDistances();
+    if (!distances.count({ from, to }) && !distances.count({ to, from })) {
+        catalogue.SetDistance(from->stop, to->stop, static_cast<size_t>(geo::ComputeDistance(from->coords, to->coords) * 1.3));
+    }
+    catalogue.AddBus("benchmark express"sv, { static_cast<uint32_t>(from->id), static_cast<uint32_t>(to->id) }, false);
+    report("one bus added"sv, router, [&](TransportRouter& updated) {
+        updated.AddBus(catalogue, "benchmark express"sv);
+    });
+
+    const auto& buses = catalogue.GetAllBuses();
+    const Bus& bus = buses[std::uniform_int_distribution<size_t>(0, buses.size() - 1)(generator)];
+    const size_t leg = std::uniform_int_distribution<size_t>(0, bus.route.size() - 2)(generator);
+    const std::string_view leg_from = catalogue.GetStopByID(bus.route[leg]).stop;
+    const std::string_view leg_to = catalogue.GetStopByID(bus.route[leg + 1]).stop;
+    catalogue.UpdateDistance(leg_from, leg_to, std::max<size_t>(catalogue.GetDistance(leg_from, leg_to) / 2, 1));
+    report("one ride made faster"sv, router, [&](TransportRouter& updated) {
+        updated.UpdateDistance(catalogue, leg_from, leg_to);
+    });
+}
+
+// a synthetic network loaded through BulkLoader and through the incremental AddStop/AddBus/SetDistance, then every
+// bus queried once. Finalize computes the stats of all buses up front, the incremental path as the last distance
+// of each bus is set; the load and the queries are timed apart
+void RunCatalogueBenchmark() {
+    constexpr size_t STOP_COUNT = 200000;
+    constexpr size_t BUS_COUNT = 20000;
+    constexpr size_t ROUTE_SIZE = 20;
+    using transport_catalogue::domain::Stop;
+
+    std::mt19937 generator(32);
+    std::uniform_real_distribution<double> lat(43.5, 43.7);
+    std::uniform_real_distribution<double> lng(39.6, 39.8);
+    std::uniform_int_distribution<uint32_t> stop(0, STOP_COUNT - 1);
+    std::uniform_int_distribution<size_t> distance(100, 5000);
+
+    std::vector<std::string> stop_names(STOP_COUNT);
+    std::vector<geo::Coordinates> coords(STOP_COUNT);
+    for (size_t i = 0; i < STOP_COUNT; ++i) {
+        stop_names[i] = "Stop "s + std::to_string(i);
+        coords[i] = { lat(generator), lng(generator) };
+    }
+    std::vector<std::string> bus_names(BUS_COUNT);
+    std::vector<std::vector<uint32_t>> routes(BUS_COUNT);
+    std::vector<size_t> distances(BUS_COUNT * ROUTE_SIZE);
+    for (size_t i = 0; i < BUS_COUNT; ++i) {
+        bus_names[i] = "Bus "s + std::to_string(i);
+        for (size_t j = 0; j < ROUTE_SIZE; ++j) {
+            routes[i].push_back(stop(generator));
+            distances[i * ROUTE_SIZE + j] = distance(generator);
+        }
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto query_all = [&](const transport_catalogue::TransportCatalogue& catalogue, double& length) {
+        const auto start = Clock::now();
+        for (const std::string& bus : bus_names) {
+            length += catalogue.GetInfoAboutBus(bus)->route_length;
+        }
+        return std::chrono::duration<double, std::milli>(Clock::now() - start);
+    };
+
+    transport_catalogue::TransportCatalogue bulk;
+    const auto bulk_start = Clock::now();
+    transport_catalogue::TransportCatalogue::BulkLoader loader(bulk);
+    loader.Reserve(STOP_COUNT, BUS_COUNT, BUS_COUNT * ROUTE_SIZE, BUS_COUNT * (ROUTE_SIZE - 1));
+    for (size_t i = 0; i < STOP_COUNT; ++i) {
+        loader.AddStop(Stop{ stop_names[i], coords[i] });
+    }
+    for (size_t i = 0; i < BUS_COUNT; ++i) {
+        loader.AddBus(bus_names[i], routes[i], false);
+        for (size_t j = 0; j + 1 < ROUTE_SIZE; ++j) {
+            loader.AddDistance(routes[i][j], routes[i][j + 1], distances[i * ROUTE_SIZE + j]);
+        }
+    }
+    const auto finalize_start = Clock::now();
+    loader.Finalize();
+    const std::chrono::duration<double, std::milli> bulk_finalize = Clock::now() - finalize_start;
+    const std::chrono::duration<double, std::milli> bulk_load = Clock::now() - bulk_start;
+    double bulk_length = 0.0;
+    const auto bulk_queries = query_all(bulk, bulk_length);
+
+    transport_catalogue::TransportCatalogue incremental;
+    const auto incremental_start = Clock::now();
+    for (size_t i = 0; i < STOP_COUNT; ++i) {
+        incremental.AddStop(Stop{ stop_names[i], coords[i] });
+    }
+    for (size_t i = 0; i < BUS_COUNT; ++i) {
+        incremental.AddBus(bus_names[i], routes[i], false);
+        for (size_t j = 0; j + 1 < ROUTE_SIZE; ++j) {
+            incremental.SetDistance(stop_names[routes[i][j]], stop_names[routes[i][j + 1]], distances[i * ROUTE_SIZE + j]);
+        }
+    }
+    incremental.BuildSpatialIndex();
+    const std::chrono::duration<double, std::milli> incremental_load = Clock::now() - incremental_start;
+    double incremental_length = 0.0;
+    const auto incremental_queries = query_all(incremental, incremental_length);
+
+    std::cout << STOP_COUNT << " stops, "sv << BUS_COUNT << " buses of "sv << ROUTE_SIZE << " stops\n"sv
+        << "bulk loader: "sv << bulk_load.count() << " ms to load, "sv << (bulk_load - bulk_finalize).count()
+        << " ms before Finalize and "sv << bulk_finalize.count()
+        << " ms in Finalize with the stats of every bus; "sv << bulk_queries.count() << " ms to query every bus\n"sv
+        << "incremental: "sv << incremental_load.count() << " ms to load; "sv << incremental_queries.count()
+        << " ms to query every bus\n"sv;
+    if (bulk_length != incremental_length) {
+        std::cout << "route lengths differ: "sv << bulk_length << " against "sv << incremental_length << '\n';
+    }
+}
+
 int main(int argc, char* argv[]) {
+    if (argc == 2 && std::string_view(argv[1]) == "benchmark_router"sv) {
+        RunRouterBenchmark();
+        return 0;
+    }
+    if (argc == 2 && std::string_view(argv[1]) == "benchmark_updates"sv) {
+        RunUpdateBenchmark();
+        return 0;
+    }
+    if (argc == 2 && std::string_view(argv[1]) == "benchmark_catalogue"sv) {
+        RunCatalogueBenchmark();
+        return 0;
+    }
+    if (argc == 2 && std::string_view(argv[1]) == "test"sv) {
+        return transport_catalogue::tests::RunAll(std::cout) ? 0 : 1;
+    }
+
     /*if (argc != 2) {
         PrintUsage();
         return 1;
@@ -1,4 +1,8 @@
 #include "map_renderer.h"
+#include <atomic>
+#include <functional>
+#include <future>
+#include <sstream>
 
 namespace transport_catalogue {
 
@@ -9,12 +13,69 @@ namespace transport_catalogue {
 				return std::abs(value) < EPSILON;
 			}
 
+			SphereProjector::SphereProjector(const StopsLayer& layer, double max_width, double max_height, double padding)
+				: padding_(padding)
+			{
+				if (layer.ids.empty()) {
+					return;
+				}
+
+				const auto [left_it, right_it] = std::minmax_element(layer.lngs.begin(), layer.lngs.end());
+				const auto [bottom_it, top_it] = std::minmax_element(layer.lats.begin(), layer.lats.end());
+				SetBounds(*left_it, *right_it, *bottom_it, *top_it, max_width, max_height);
+			}
+
 			svg::Point SphereProjector::operator()(geo::Coordinates coords) const {
 				return {
 						(coords.lng - min_lon_) * zoom_coeff_ + padding_,
 						(max_lat_ - coords.lat) * zoom_coeff_ + padding_
 				};
 			}
+
+			std::vector<svg::Point> SphereProjector::ProjectLayer(const StopsLayer& layer) const {
+				const size_t count = layer.ids.size();
+
+				// plain loops over contiguous arrays, so the compiler is free to vectorize them
+				std::vector<double> xs(count);
+				for (size_t i = 0; i < count; ++i) {
+					xs[i] = (layer.lngs[i] - min_lon_) * zoom_coeff_ + padding_;
+				}
+				std::vector<double> ys(count);
+				for (size_t i = 0; i < count; ++i) {
+					ys[i] = (max_lat_ - layer.lats[i]) * zoom_coeff_ + padding_;
+				}
+
+				std::vector<svg::Point> points(count == 0 ? 0 : layer.ids.back() + 1);
+				for (size_t i = 0; i < count; ++i) {
+					points[layer.ids[i]] = { xs[i], ys[i] };
+				}
+				return points;
+			}
+
+			void SphereProjector::SetBounds(double min_lon, double max_lon, double min_lat, double max_lat, double max_width, double max_height) {
+				min_lon_ = min_lon;
+				max_lat_ = max_lat;
+
+				std::optional<double> width_zoom;
+				if (!IsZero(max_lon - min_lon_)) {
+					width_zoom = (max_width - 2 * padding_) / (max_lon - min_lon_);
+				}
+
+				std::optional<double> height_zoom;
+				if (!IsZero(max_lat_ - min_lat)) {
+					height_zoom = (max_height - 2 * padding_) / (max_lat_ - min_lat);
+				}
+
+				if (width_zoom && height_zoom) {
+					zoom_coeff_ = std::min(*width_zoom, *height_zoom);
+				}
+				else if (width_zoom) {
+					zoom_coeff_ = *width_zoom;
+				}
+				else if (height_zoom) {
+					zoom_coeff_ = *height_zoom;
+				}
+			}
 		}
 
 		// --------- MapRenderer PUBLIC -------------------
@@ -22,56 +83,158 @@ namespace transport_catalogue {
             return settings_;
         }
 
-        void MapRenderer::DrawMap(std::ostream& out, const std::set<domain::Bus>& buses) const {
+        void MapRenderer::SetThreadCount(size_t thread_count) {
+            thread_count_ = std::max<size_t>(thread_count, 1);
+        }
+
+        void MapRenderer::DrawMap(std::ostream& out, const std::set<domain::Bus>& buses, const std::deque<domain::Stop>& stops) const {
 
-            //1) define scaling coefficients
-            detail::SphereProjector projector = BuildProjector(buses);
+            //1) project every stop of the map exactly once
+            detail::ProjectedStops projected = ProjectStops(buses, stops);
+            const std::vector<svg::Point>& points = projected.points;
+
+            if (thread_count_ > 1 && buses.size() >= detail::PARALLEL_MIN_BUSES) {
+                DrawMapParallel(out, buses, projected);
+                return;
+            }
 
             //2) put objects on map, layer by layer
             svg::Document map_doc;
             // I 
             int color_index = 0;
-            std::for_each(buses.begin(), buses.end(), [&](const auto& bus) { AddBusToMap(bus, projector, color_index, map_doc); });
+            std::for_each(buses.begin(), buses.end(), [&](const auto& bus) { AddBusToMap(bus, points, color_index, map_doc); });
             // II 
             color_index = 0;
-            std::for_each(buses.begin(), buses.end(), [&](const auto& bus) { AddBusNameToMap(bus, projector, color_index, map_doc); });
+            std::for_each(buses.begin(), buses.end(), [&](const auto& bus) { AddBusNameToMap(bus, points, color_index, map_doc); });
             // III 
-            auto stops = GetStopsFromBuses(buses);
-            std::for_each(stops.begin(), stops.end(), [&](const auto& stop) { AddStopToMap(stop, projector, map_doc); });
+            std::for_each(projected.stops.begin(), projected.stops.end(), [&](const auto* stop) { AddStopToMap(*stop, points, map_doc); });
             // IV 
-            std::for_each(stops.begin(), stops.end(), [&](const auto& stop) { AddStopNameToMap(stop, projector, map_doc); });
+            std::for_each(projected.stops.begin(), projected.stops.end(), [&](const auto* stop) { AddStopNameToMap(*stop, points, map_doc); });
 
             //3) draw
             map_doc.Render(out);
         }
 
+        detail::ProjectedStops MapRenderer::ProjectStops(const std::set<domain::Bus>& buses, const std::deque<domain::Stop>& stops) const {
+            std::vector<uint32_t> stop_ids;
+            for (const domain::Bus& bus : buses) {
+                stop_ids.insert(stop_ids.end(), bus.route.begin(), bus.route.end());
+            }
+            std::sort(stop_ids.begin(), stop_ids.end());
+            stop_ids.erase(std::unique(stop_ids.begin(), stop_ids.end()), stop_ids.end());
+
+            detail::StopsLayer layer;
+            std::vector<const domain::Stop*> map_stops;
+            layer.ids.reserve(stop_ids.size());
+            layer.lats.reserve(stop_ids.size());
+            layer.lngs.reserve(stop_ids.size());
+            map_stops.reserve(stop_ids.size());
+            for (uint32_t stop_id : stop_ids) {
+                const domain::Stop& stop = stops[stop_id];
+                layer.ids.push_back(stop_id);
+                layer.lats.push_back(stop.coords.lat);
+                layer.lngs.push_back(stop.coords.lng);
+                map_stops.push_back(&stop);
+            }
+
+            detail::SphereProjector projector(layer, settings_.width, settings_.height, settings_.padding);
+
+            std::sort(map_stops.begin(), map_stops.end(), [](const domain::Stop* lhs, const domain::Stop* rhs) { return *lhs < *rhs; });
+            return { projector.ProjectLayer(layer), std::move(map_stops) };
+        }
+
         // --------- MapRenderer PRIVATE -------------------
-        detail::SphereProjector MapRenderer::BuildProjector(const std::set<domain::Bus>& data) const {
-            std::vector<geo::Coordinates> coords;
+        void MapRenderer::DrawMapParallel(std::ostream& out, const std::set<domain::Bus>& buses, const detail::ProjectedStops& projected) const {
+            const std::vector<svg::Point>& points = projected.points;
+
+            // color of each bus is fixed up front, so chunks do not depend on each other
+            std::vector<const domain::Bus*> bus_list;
+            std::vector<int> colors;
+            bus_list.reserve(buses.size());
+            colors.reserve(buses.size());
+            int color_index = 0;
+            for (const domain::Bus& bus : buses) {
+                bus_list.push_back(&bus);
+                colors.push_back(color_index);
+                if (!bus.route.empty()) {
+                    color_index = (color_index + 1) % static_cast<int>(settings_.color_palette.size());
+                }
+            }
 
-            for (const domain::Bus& bus : data) {
-                for (const domain::Stop* stop : bus.route) {
-                    coords.push_back(stop->coords);
+            // chunks are listed in the canonical order: layer by layer, bus by bus, stop by stop
+            std::vector<std::function<void(svg::Document&)>> chunks;
+            const size_t bus_step = (bus_list.size() + thread_count_ - 1) / thread_count_;
+            const size_t stop_step = std::max<size_t>((projected.stops.size() + thread_count_ - 1) / thread_count_, 1);
+            for (size_t first = 0; first < bus_list.size(); first += bus_step) {
+                const size_t last = std::min(first + bus_step, bus_list.size());
+                chunks.push_back([&, first, last](svg::Document& doc) {
+                    int color = colors[first];
+                    std::for_each(bus_list.begin() + first, bus_list.begin() + last, [&](const auto* bus) { AddBusToMap(*bus, points, color, doc); });
+                });
+            }
+            for (size_t first = 0; first < bus_list.size(); first += bus_step) {
+                const size_t last = std::min(first + bus_step, bus_list.size());
+                chunks.push_back([&, first, last](svg::Document& doc) {
+                    int color = colors[first];
+                    std::for_each(bus_list.begin() + first, bus_list.begin() + last, [&](const auto* bus) { AddBusNameToMap(*bus, points, color, doc); });
+                });
+            }
+            for (size_t first = 0; first < projected.stops.size(); first += stop_step) {
+                const size_t last = std::min(first + stop_step, projected.stops.size());
+                chunks.push_back([&, first, last](svg::Document& doc) {
+                    std::for_each(projected.stops.begin() + first, projected.stops.begin() + last, [&](const auto* stop) { AddStopToMap(*stop, points, doc); });
+                });
+            }
+            for (size_t first = 0; first < projected.stops.size(); first += stop_step) {
+                const size_t last = std::min(first + stop_step, projected.stops.size());
+                chunks.push_back([&, first, last](svg::Document& doc) {
+                    std::for_each(projected.stops.begin() + first, projected.stops.begin() + last, [&](const auto* stop) { AddStopNameToMap(*stop, points, doc); });
+                });
+            }
+
+            // every worker takes the next chunk and renders it into its own buffer
+            std::vector<std::string> rendered(chunks.size());
+            std::atomic_size_t next_chunk = 0;
+            auto worker = [&]() {
+                for (size_t i = next_chunk++; i < chunks.size(); i = next_chunk++) {
+                    svg::Document chunk_doc;
+                    chunks[i](chunk_doc);
+                    std::ostringstream stream;
+                    chunk_doc.RenderObjects(stream);
+                    rendered[i] = stream.str();
                 }
+            };
+
+            std::vector<std::future<void>> workers;
+            for (size_t i = 1; i < std::min(thread_count_, chunks.size()); ++i) {
+                workers.push_back(std::async(std::launch::async, worker));
+            }
+            worker();
+            for (auto& future : workers) {
+                future.get();
             }
 
-            return { coords.begin(), coords.end(), settings_.width, settings_.height, settings_.padding };
+            svg::Document::RenderBegin(out);
+            for (const std::string& part : rendered) {
+                out << part;
+            }
+            svg::Document::RenderEnd(out);
         }
 
-        void MapRenderer::AddBusToMap(const domain::Bus& bus, const detail::SphereProjector& projector, int& color_index, svg::Document& map_doc) const {
+        void MapRenderer::AddBusToMap(const domain::Bus& bus, const std::vector<svg::Point>& points, int& color_index, svg::Document& map_doc) const {
             if (bus.route.empty()) {
                 return;
             }
 
             svg::Polyline route;
 
-            for (const domain::Stop* stop : bus.route) {
-                route.AddPoint(projector(stop->coords));
+            for (uint32_t stop_id : bus.route) {
+                route.AddPoint(points[stop_id]);
             }
 
             if (!bus.is_circle) {
                 for (auto it = bus.route.rbegin() + 1; it != bus.route.rend(); ++it) {
-                    route.AddPoint(projector((*it)->coords));
+                    route.AddPoint(points[*it]);
                 }
             }
 
@@ -83,14 +246,14 @@ namespace transport_catalogue {
             color_index = (color_index + 1) % static_cast<int>(settings_.color_palette.size());
         }
 
-        void MapRenderer::AddBusNameToMap(const domain::Bus& bus, const detail::SphereProjector& projector, int& color_index, svg::Document& map_doc) const {
+        void MapRenderer::AddBusNameToMap(const domain::Bus& bus, const std::vector<svg::Point>& points, int& color_index, svg::Document& map_doc) const {
             if (bus.route.empty()) {
                 return;
             }
 
             svg::Text under_text;
-            under_text.SetData(bus.bus).SetFontFamily("Verdana").SetFontWeight("bold").SetFontSize(settings_.bus_label_font_size);
-            under_text.SetOffset(settings_.bus_label_offset).SetPosition(projector(bus.route[0]->coords));
+            under_text.SetData(std::string(bus.bus)).SetFontFamily("Verdana").SetFontWeight("bold").SetFontSize(settings_.bus_label_font_size);
+            under_text.SetOffset(settings_.bus_label_offset).SetPosition(points[bus.route[0]]);
 
             svg::Text text(under_text);
             text.SetFillColor(settings_.color_palette.at(color_index));
@@ -103,8 +266,8 @@ namespace transport_catalogue {
             map_doc.Add(text);
 
             if (!bus.is_circle && bus.route.back() != bus.route.front()) {
-                under_text.SetPosition(projector(bus.route.back()->coords));
-                text.SetPosition(projector(bus.route.back()->coords));
+                under_text.SetPosition(points[bus.route.back()]);
+                text.SetPosition(points[bus.route.back()]);
                 map_doc.Add(under_text);
                 map_doc.Add(text);
             }
@@ -112,28 +275,16 @@ namespace transport_catalogue {
             color_index = (color_index + 1) % static_cast<int>(settings_.color_palette.size());
         }
 
-        std::set<domain::Stop> MapRenderer::GetStopsFromBuses(const std::set<domain::Bus>& all_buses) const {
-            std::set<domain::Stop> stops;
-
-            for (const auto& bus : all_buses) {
-                for (const domain::Stop* stop : bus.route) {
-                    stops.insert(*stop);
-                }
-            }
-
-            return stops;
-        }
-
-        void MapRenderer::AddStopToMap(const domain::Stop& stop, const detail::SphereProjector& projector, svg::Document& map_doc) const {
+        void MapRenderer::AddStopToMap(const domain::Stop& stop, const std::vector<svg::Point>& points, svg::Document& map_doc) const {
             svg::Circle circle;
-            circle.SetRadius(settings_.stop_radius).SetFillColor("white").SetCenter(projector(stop.coords));
+            circle.SetRadius(settings_.stop_radius).SetFillColor("white").SetCenter(points[stop.id]);
             map_doc.Add(circle);
         }
 
-        void MapRenderer::AddStopNameToMap(const domain::Stop& stop, const detail::SphereProjector& projector, svg::Document& map_doc) const {
+        void MapRenderer::AddStopNameToMap(const domain::Stop& stop, const std::vector<svg::Point>& points, svg::Document& map_doc) const {
             svg::Text under_text;
-            under_text.SetData(stop.stop).SetFontFamily("Verdana").SetFontSize(settings_.stop_label_font_size);
-            under_text.SetOffset(settings_.stop_label_offset).SetPosition(projector(stop.coords));
+            under_text.SetData(std::string(stop.stop)).SetFontFamily("Verdana").SetFontSize(settings_.stop_label_font_size);
+            under_text.SetOffset(settings_.stop_label_offset).SetPosition(points[stop.id]);
 
             svg::Text text(under_text);
             text.SetFillColor("black");
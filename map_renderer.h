@@ -2,18 +2,29 @@
 
 #include "svg.h"
 #include "domain.h"
+#include <deque>
 #include <set>
+#include <vector>
 #include <memory>
 #include <cassert>
 #include <algorithm>
+#include <thread>
 
 namespace transport_catalogue {
 	namespace interfaces {
 		namespace detail {
 			inline const double EPSILON = 1e-6;
+			inline const size_t PARALLEL_MIN_BUSES = 32; // smaller maps are not worth the threads
 			
 			bool IsZero(double value);
 
+			// unique stops of a map in struct-of-arrays form, ordered by stop ID
+			struct StopsLayer {
+				std::vector<size_t> ids;
+				std::vector<double> lats;
+				std::vector<double> lngs;
+			};
+
 			class SphereProjector {
 			public:
 				template <typename PointInputIt>
@@ -28,43 +39,33 @@ namespace transport_catalogue {
 				    const auto [left_it, right_it] = std::minmax_element(
 					points_begin, points_end,
 					[](auto lhs, auto rhs) { return lhs.lng < rhs.lng; });
-				    min_lon_ = left_it->lng;
-				    const double max_lon = right_it->lng;
 				
 				    const auto [bottom_it, top_it] = std::minmax_element(
 					points_begin, points_end,
 					[](auto lhs, auto rhs) { return lhs.lat < rhs.lat; });
-				    const double min_lat = bottom_it->lat;
-				    max_lat_ = top_it->lat;
-				
-				    std::optional<double> width_zoom;
-				    if (!IsZero(max_lon - min_lon_)) {
-					width_zoom = (max_width - 2 * padding) / (max_lon - min_lon_);
-				    }
-				
-				    std::optional<double> height_zoom;
-				    if (!IsZero(max_lat_ - min_lat)) {
-					height_zoom = (max_height - 2 * padding) / (max_lat_ - min_lat);
-				    }
-				
-				    if (width_zoom && height_zoom) {
-					zoom_coeff_ = std::min(*width_zoom, *height_zoom);
-				    }
-				    else if (width_zoom) {
-					zoom_coeff_ = *width_zoom;
-				    }
-				    else if (height_zoom) {
-					zoom_coeff_ = *height_zoom;
-				    }
+
+				    SetBounds(left_it->lng, right_it->lng, bottom_it->lat, top_it->lat, max_width, max_height);
 				}
+
+				SphereProjector(const StopsLayer& layer, double max_width, double max_height, double padding);
 				
 				svg::Point operator()(geo::Coordinates coords) const;
+
+				// projects the whole layer at once, the result is indexed by stop ID
+				std::vector<svg::Point> ProjectLayer(const StopsLayer& layer) const;
 			
 			private:
 				double padding_;
 				double min_lon_ = 0;
 				double max_lat_ = 0;
 				double zoom_coeff_ = 0;
+
+				void SetBounds(double min_lon, double max_lon, double min_lat, double max_lat, double max_width, double max_height);
+			};
+
+			struct ProjectedStops {
+				std::vector<svg::Point> points; // indexed by stop ID
+				std::vector<const domain::Stop*> stops; // unique stops of the map, sorted by name
 			};
         }
 
@@ -93,18 +94,22 @@ namespace transport_catalogue {
 			}
 
            	const Settings& GetSettings() const;            
+
+			// 1 draws the map sequentially, more splits layers into chunks rendered concurrently
+			void SetThreadCount(size_t thread_count);
             
-			void DrawMap(std::ostream& out, const std::set<domain::Bus>& buses) const;
+			void DrawMap(std::ostream& out, const std::set<domain::Bus>& buses, const std::deque<domain::Stop>& stops) const;
+			detail::ProjectedStops ProjectStops(const std::set<domain::Bus>& buses, const std::deque<domain::Stop>& stops) const;
 
 		private:
 			Settings settings_;
+			size_t thread_count_ = std::max(1u, std::thread::hardware_concurrency());
 
-			detail::SphereProjector BuildProjector(const std::set<domain::Bus>& data) const;
-			void AddBusToMap(const domain::Bus& bus, const detail::SphereProjector& projector, int& color_index, svg::Document& map_doc) const;       
-			void AddBusNameToMap(const domain::Bus& bus, const detail::SphereProjector& projector, int& color_index, svg::Document& map_doc) const;
-			std::set<domain::Stop> GetStopsFromBuses(const std::set<domain::Bus>& all_buses) const;
-			void AddStopToMap(const domain::Stop& stop, const detail::SphereProjector& projector, svg::Document& map_doc) const;
-			void AddStopNameToMap(const domain::Stop& stop, const detail::SphereProjector& projector, svg::Document& map_doc) const;
+			void DrawMapParallel(std::ostream& out, const std::set<domain::Bus>& buses, const detail::ProjectedStops& projected) const;
+			void AddBusToMap(const domain::Bus& bus, const std::vector<svg::Point>& points, int& color_index, svg::Document& map_doc) const;       
+			void AddBusNameToMap(const domain::Bus& bus, const std::vector<svg::Point>& points, int& color_index, svg::Document& map_doc) const;
+			void AddStopToMap(const domain::Stop& stop, const std::vector<svg::Point>& points, svg::Document& map_doc) const;
+			void AddStopNameToMap(const domain::Stop& stop, const std::vector<svg::Point>& points, svg::Document& map_doc) const;
 		};	
 	}
 }
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "dijkstra.h"
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Bounded LRU cache of shortest path trees by source vertex, shared by the worker threads. A route from
+    // a cached source is only a walk back along its tree; a miss runs one full Dijkstra, outside the lock,
+    // so two threads missing the same source at once may both build its tree.
+    template <typename Weight>
+    class ShortestPathTreeCache {
+    public:
+        using RouteInfo = typename Router<Weight>::RouteInfo;
+        using TreePtr = std::shared_ptr<const ShortestPathTree<Weight>>; // stays valid after eviction
+
+        struct Stats {
+            size_t hits = 0;
+            size_t misses = 0;
+        };
+
+        ShortestPathTreeCache(const DirectedWeightedGraph<Weight>& graph, size_t capacity)
+            : graph_(graph)
+            , capacity_(std::max<size_t>(capacity, 1)) {
+        }
+
+        TreePtr GetTree(VertexId source) const;
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+        Stats GetStats() const {
+            std::lock_guard guard(mutex_);
+            return stats_;
+        }
+
+        size_t GetCapacity() const {
+            return capacity_;
+        }
+
+        // the graph changed: every tree is stale, the counters stay
+        void Clear() {
+            std::lock_guard guard(mutex_);
+            trees_.clear();
+            tree_by_source_.clear();
+        }
+
+    private:
+        const DirectedWeightedGraph<Weight>& graph_;
+        size_t capacity_;
+        mutable std::mutex mutex_;
+        mutable std::list<TreePtr> trees_; // most recently used first
+        mutable std::unordered_map<VertexId, typename std::list<TreePtr>::iterator> tree_by_source_;
+        mutable Stats stats_;
+    };
+
+    template <typename Weight>
+    typename ShortestPathTreeCache<Weight>::TreePtr ShortestPathTreeCache<Weight>::GetTree(VertexId source) const {
+        {
+            std::lock_guard guard(mutex_);
+            if (auto it = tree_by_source_.find(source); it != tree_by_source_.end()) {
+                ++stats_.hits;
+                trees_.splice(trees_.begin(), trees_, it->second);
+                return trees_.front();
+            }
+            ++stats_.misses;
+        }
+
+        TreePtr tree = std::make_shared<const ShortestPathTree<Weight>>(BuildShortestPathTree(graph_, source));
+
+        std::lock_guard guard(mutex_);
+        if (auto it = tree_by_source_.find(source); it != tree_by_source_.end()) {
+            trees_.splice(trees_.begin(), trees_, it->second); // another thread was first
+            return trees_.front();
+        }
+        trees_.push_front(tree);
+        tree_by_source_[source] = trees_.begin();
+        if (trees_.size() > capacity_) {
+            tree_by_source_.erase(trees_.back()->source);
+            trees_.pop_back();
+        }
+        return tree;
+    }
+
+    template <typename Weight>
+    std::optional<typename ShortestPathTreeCache<Weight>::RouteInfo> ShortestPathTreeCache<Weight>::BuildRoute(VertexId from,
+        VertexId to) const {
+        const TreePtr tree = GetTree(from);
+        if (tree->weights.at(to) == std::numeric_limits<Weight>::max()) {
+            return std::nullopt;
+        }
+        return RouteInfo{ tree->weights[to], GetTreePath(graph_, *tree, to) };
+    }
+
+}  // namespace graph
@@ -0,0 +1,146 @@
+#include "raptor_router.h"
+#include "transport_router.h"
+
+#include <algorithm>
+
+namespace transport_catalogue {
+
+	RaptorRouter::RaptorRouter(const TransportCatalogue& catalog, const TransportGraph& graph)
+		: graph_(graph) {
+		Rebuild(catalog);
+	}
+
+	void RaptorRouter::Rebuild(const TransportCatalogue& catalog) {
+		patterns_.clear();
+		pattern_stops_.clear();
+		for (const Bus& bus : catalog.GetAllBuses()) {
+			if (bus.route.size() < 2) {
+				continue; // no rides, and no edges in the graph either
+			}
+			const graph::EdgeId first_edge = graph_.GetBusEdges(bus.bus).first;
+			std::vector<uint32_t> route(bus.route.begin(), bus.route.end());
+			AddPattern(catalog, route, first_edge);
+			if (!bus.is_circle) {
+				const graph::EdgeId forward_edges = route.size() * (route.size() - 1) / 2;
+				std::reverse(route.begin(), route.end());
+				AddPattern(catalog, route, first_edge + forward_edges);
+			}
+		}
+
+		const size_t vertex_count = graph_.GetInnerGraph().GetVertexCount();
+		stop_pattern_offsets_.assign(vertex_count + 1, 0);
+		for (graph::VertexId vertex : pattern_stops_) {
+			++stop_pattern_offsets_[vertex + 1];
+		}
+		for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+			stop_pattern_offsets_[vertex + 1] += stop_pattern_offsets_[vertex];
+		}
+		stop_patterns_.resize(pattern_stops_.size());
+		std::vector<size_t> next(stop_pattern_offsets_.begin(), stop_pattern_offsets_.end() - 1);
+		for (uint32_t pattern = 0; pattern < patterns_.size(); ++pattern) {
+			for (uint32_t position = 0; position < patterns_[pattern].stop_count; ++position) {
+				const graph::VertexId vertex = pattern_stops_[patterns_[pattern].first_stop + position];
+				stop_patterns_[next[vertex]++] = { pattern, position };
+			}
+		}
+	}
+
+	void RaptorRouter::AddPattern(const TransportCatalogue& catalog, const std::vector<uint32_t>& route, graph::EdgeId first_edge) {
+		patterns_.push_back({ pattern_stops_.size(), static_cast<uint32_t>(route.size()), first_edge });
+		for (uint32_t stop_id : route) {
+			pattern_stops_.push_back(graph_.GetStopVertexID(catalog.GetStopByID(stop_id).stop));
+		}
+	}
+
+	std::vector<RaptorRouter::Journey> RaptorRouter::FindJourneys(graph::VertexId from, graph::VertexId to) const {
+		if (from == to) {
+			return { { RouteWeight{}, 0, {} } };
+		}
+
+		const auto& graph = graph_.GetInnerGraph();
+		const RouteWeight wait_time = ToRouteWeight(graph_.GetSettings().wait_time);
+		const size_t vertex_count = graph.GetVertexCount();
+		const RouteWeight unreached = std::numeric_limits<RouteWeight>::max();
+
+		std::vector<std::vector<RouteWeight>> arrival(1, std::vector<RouteWeight>(vertex_count, unreached)); // by round
+		std::vector<std::vector<Leg>> legs(1, std::vector<Leg>(vertex_count));
+		std::vector<RouteWeight> best(vertex_count, unreached); // over all rounds so far
+		arrival[0][from] = best[from] = RouteWeight{};
+
+		std::vector<graph::VertexId> marked = { from };
+		std::vector<bool> is_marked(vertex_count, false);
+		std::vector<uint32_t> first_position(patterns_.size(), NO_POSITION);
+		std::vector<uint32_t> queue;
+
+		while (!marked.empty()) {
+			// every route through a stop improved last round, from the earliest such stop on it
+			for (graph::VertexId vertex : marked) {
+				is_marked[vertex] = false;
+				for (size_t i = stop_pattern_offsets_[vertex]; i < stop_pattern_offsets_[vertex + 1]; ++i) {
+					const auto [pattern, position] = stop_patterns_[i];
+					if (first_position[pattern] == NO_POSITION) {
+						queue.push_back(pattern);
+					}
+					first_position[pattern] = std::min(first_position[pattern], position);
+				}
+			}
+			marked.clear();
+
+			arrival.push_back(arrival.back());
+			legs.emplace_back(vertex_count);
+			const std::vector<RouteWeight>& previous = arrival[arrival.size() - 2];
+			std::vector<RouteWeight>& current = arrival.back();
+			std::vector<Leg>& round_legs = legs.back();
+
+			for (uint32_t pattern_id : queue) {
+				const Pattern& pattern = patterns_[pattern_id];
+				const graph::VertexId* stops = pattern_stops_.data() + pattern.first_stop;
+				uint32_t board = NO_POSITION;
+				for (uint32_t position = first_position[pattern_id]; position < pattern.stop_count; ++position) {
+					const graph::VertexId vertex = stops[position];
+					RouteWeight ride_arrival = unreached;
+					if (board != NO_POSITION) {
+						ride_arrival = previous[stops[board]] + graph.GetEdge(GetEdge(pattern, board, position)).weight;
+						// no use arriving later than at the stop or at the target already
+						if (ride_arrival < std::min(best[vertex], best[to])) {
+							current[vertex] = best[vertex] = ride_arrival;
+							round_legs[vertex] = { pattern_id, board, position };
+							if (!is_marked[vertex]) {
+								is_marked[vertex] = true;
+								marked.push_back(vertex);
+							}
+						}
+					}
+					// boarding here beats staying on if the stop was reached sooner than the ride gets here
+					if (previous[vertex] != unreached && (board == NO_POSITION || previous[vertex] + wait_time < ride_arrival)) {
+						board = position;
+					}
+				}
+				first_position[pattern_id] = NO_POSITION;
+			}
+			queue.clear();
+		}
+
+		std::vector<Journey> journeys;
+		for (size_t round = 1; round < arrival.size(); ++round) {
+			if (arrival[round][to] >= arrival[round - 1][to]) {
+				continue;
+			}
+			Journey journey{ arrival[round][to], 0, {} };
+			size_t leg_round = round;
+			for (graph::VertexId vertex = to; vertex != from; --leg_round) {
+				while (legs[leg_round][vertex].pattern == NO_POSITION) {
+					--leg_round; // the arrival was carried over from an earlier round
+				}
+				const Leg& leg = legs[leg_round][vertex];
+				const Pattern& pattern = patterns_[leg.pattern];
+				journey.edges.push_back(GetEdge(pattern, leg.board, leg.alight));
+				vertex = pattern_stops_[pattern.first_stop + leg.board];
+			}
+			std::reverse(journey.edges.begin(), journey.edges.end());
+			journey.transfers = journey.edges.size() - 1;
+			journeys.push_back(std::move(journey));
+		}
+		return journeys;
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "transport_catalogue.h"
+#include "graph.h"
+#include "route_weight.h"
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace transport_catalogue {
+
+	class TransportGraph;
+
+	// Round-based routing over the bus routes themselves (RAPTOR): round k scans every route touched in
+	// round k - 1 once, front to back, so after it each stop holds its earliest arrival with at most k rides.
+	// No preprocessing; a ride from one stop of a route to a later one is the same edge TransportGraph has,
+	// with its weight, so both agree on times and segments.
+	class RaptorRouter {
+	public:
+		struct Journey {
+			RouteWeight weight;
+			size_t transfers;
+			std::vector<graph::EdgeId> edges;
+		};
+
+		RaptorRouter(const TransportCatalogue& catalog, const TransportGraph& graph);
+		// the routes of other over graph, a copy of its graph
+		RaptorRouter(const TransportGraph& graph, const RaptorRouter& other)
+			: graph_(graph)
+			, patterns_(other.patterns_)
+			, pattern_stops_(other.pattern_stops_)
+			, stop_pattern_offsets_(other.stop_pattern_offsets_)
+			, stop_patterns_(other.stop_patterns_) {
+		}
+
+		// the Pareto set over (transfers, time): every fewest-transfer journey that is faster than all journeys
+		// with fewer transfers, by growing transfers; empty if to is unreachable
+		std::vector<Journey> FindJourneys(graph::VertexId from, graph::VertexId to) const;
+
+		// the routes of the buses changed
+		void Rebuild(const TransportCatalogue& catalog);
+
+	private:
+		static constexpr uint32_t NO_POSITION = std::numeric_limits<uint32_t>::max();
+
+		// one direction of a bus: its stops in riding order and where its edges start
+		struct Pattern {
+			size_t first_stop;
+			uint32_t stop_count;
+			graph::EdgeId first_edge;
+		};
+
+		// the ride of one round that improved a stop
+		struct Leg {
+			uint32_t pattern = NO_POSITION;
+			uint32_t board = 0;
+			uint32_t alight = 0;
+		};
+
+		const TransportGraph& graph_;
+		std::vector<Pattern> patterns_;
+		std::vector<graph::VertexId> pattern_stops_;
+		std::vector<size_t> stop_pattern_offsets_;                 // by vertex, into stop_patterns_
+		std::vector<std::pair<uint32_t, uint32_t>> stop_patterns_; // pattern and position of each visit
+
+		void AddPattern(const TransportCatalogue& catalog, const std::vector<uint32_t>& route, graph::EdgeId first_edge);
+		// TransportGraph adds the rides of a direction from each stop to every later one in turn
+		graph::EdgeId GetEdge(const Pattern& pattern, uint32_t board, uint32_t alight) const {
+			const graph::EdgeId board_edges = static_cast<graph::EdgeId>(board) * (pattern.stop_count - 1)
+				- static_cast<graph::EdgeId>(board) * (board - 1) / 2;
+			return pattern.first_edge + board_edges + (alight - board - 1);
+		}
+	};
+}
@@ -24,30 +24,173 @@ namespace transport_catalogue {
 			return requests_;
 		}
 
-		std::optional<std::set<std::string_view>> RequestHandler::InfoStopRequest(const RequestHandler::Query& query) const {
-			return catalogue_.GetBusesByStop(query.parameters.at(0));
+		SnapshotStore::Guard RequestHandler::Pin() {
+			if (!snapshots_) {
+				auto initial = std::make_unique<Snapshot>();
+				// not owned: the loaded catalogue outlives the handler
+				initial->catalogue = std::shared_ptr<const TransportCatalogue>(std::shared_ptr<const TransportCatalogue>(), &catalogue_);
+				initial->router = router_;
+				initial->timetable_router = timetable_router_;
+				if (renderer_) {
+					initial->render_settings = renderer_->GetSettings();
+				}
+				snapshots_ = std::make_unique<SnapshotStore>(std::move(initial));
+				reader_.emplace(snapshots_->RegisterReader());
+			}
+			return reader_->Pin();
 		}
 
-		std::optional<domain::BusInfo> RequestHandler::InfoBusRequest(const RequestHandler::Query& query) const {
-			return catalogue_.GetInfoAboutBus(query.parameters.at(0));
+		void RequestHandler::UpdateNetwork(const std::function<void(NetworkEdit&)>& change) {
+			std::lock_guard guard(update_mutex_);
+			if (!snapshots_) {
+				throw std::logic_error("No snapshot was published yet");
+			}
+			std::unique_ptr<TransportCatalogue> catalogue;
+			std::unique_ptr<TransportRouter> router;
+			{
+				const SnapshotStore::Reader reader = snapshots_->RegisterReader();
+				const SnapshotStore::Guard current = reader.Pin();
+				catalogue = std::make_unique<TransportCatalogue>(*current->catalogue);
+				if (current->router) {
+					router = std::make_unique<TransportRouter>(*current->router);
+				}
+			}
+			NetworkEdit edit(*catalogue, router.get());
+			change(edit);
+
+			std::optional<MapRenderer::Settings> render_settings;
+			if (renderer_) {
+				render_settings = renderer_->GetSettings();
+			}
+			snapshots_->Publish(BuildSnapshot(std::move(catalogue), std::move(router), render_settings, timetable_));
 		}
 
-		std::set<domain::Bus> RequestHandler::AllBusesRequest() const {
-			return { catalogue_.GetAllBuses().begin(), catalogue_.GetAllBuses().end() };
+		void RequestHandler::SetRouterSettings(const TransportGraph::Settings& settings) {
+			std::lock_guard guard(update_mutex_);
+			if (!snapshots_) {
+				if (router_) {
+					router_->SetSettings(settings); // same network, only the weights change
+				}
+				else {
+					router_ = std::make_shared<TransportRouter>(catalogue_, settings);
+				}
+				UpdateTimetableRouter(); // trips run at the routing velocity
+				return;
+			}
+
+			std::shared_ptr<const TransportCatalogue> catalogue;
+			std::unique_ptr<TransportRouter> router;
+			{
+				const SnapshotStore::Reader reader = snapshots_->RegisterReader();
+				const SnapshotStore::Guard current = reader.Pin();
+				catalogue = current->catalogue;
+				if (current->router) {
+					router = std::make_unique<TransportRouter>(*current->router);
+				}
+			}
+			if (router) {
+				router->SetSettings(settings);
+			}
+			else {
+				router = std::make_unique<TransportRouter>(*catalogue, settings);
+			}
+
+			std::optional<MapRenderer::Settings> render_settings;
+			if (renderer_) {
+				render_settings = renderer_->GetSettings();
+			}
+			snapshots_->Publish(BuildSnapshot(std::move(catalogue), std::move(router), render_settings, timetable_));
 		}
 
-		void RequestHandler::DrawMapRequest(std::ostream& out) const {
-			if (!renderer_) {
+		const TransportRouter& RequestHandler::GetRouter(const Snapshot& snapshot) {
+			if (!snapshot.router) {
+				throw std::logic_error("The router was not created");
+			}
+			return *snapshot.router;
+		}
+
+		std::optional<StopBusesView> RequestHandler::InfoStopRequest(const Snapshot& snapshot, const RequestHandler::Query& query) const {
+			return snapshot.catalogue->GetBusesByStop(query.parameters.at(0));
+		}
+
+		std::optional<domain::BusInfo> RequestHandler::InfoBusRequest(const Snapshot& snapshot, const RequestHandler::Query& query) const {
+			return snapshot.catalogue->GetInfoAboutBus(query.parameters.at(0));
+		}
+
+		std::set<domain::Bus> RequestHandler::AllBusesRequest(const Snapshot& snapshot) const {
+			return { snapshot.catalogue->GetAllBuses().begin(), snapshot.catalogue->GetAllBuses().end() };
+		}
+
+		void RequestHandler::DrawMapRequest(const Snapshot& snapshot, std::ostream& out) const {
+			if (!snapshot.render_settings) {
 				throw std::logic_error("The renderer was not created");
 			}
-			renderer_->DrawMap(out, AllBusesRequest());
+			out << snapshot.GetMap();
 		}
 
-		std::optional<TransportRouter::TransportRouteInfo> RequestHandler::GetShortestRouteRequest(const RequestHandler::Query& query) const {
-			if (!router_) {
-				throw std::logic_error("The router was not created");
+		std::optional<TransportRouter::TransportRouteInfo> RequestHandler::GetShortestRouteRequest(const Snapshot& snapshot, const RequestHandler::Query& query) const {
+			return GetRouter(snapshot).GetShortestRoute(query.parameters.at(0), query.parameters.at(1));
+		}
+
+		void RequestHandler::SetTimetable(Timetable timetable) {
+			timetable_ = std::move(timetable);
+			UpdateTimetableRouter();
+		}
+
+		const Timetable& RequestHandler::GetTimetable() const {
+			return timetable_;
+		}
+
+		void RequestHandler::UpdateTimetableRouter() {
+			if (!router_ || timetable_.empty()) {
+				timetable_router_.reset();
+				return;
+			}
+			timetable_router_ = std::make_shared<TimetableRouter>(catalogue_, router_->GetTransportGraph(), timetable_);
+		}
+
+		std::optional<TimetableRouter::Journey> RequestHandler::TimetableRouteRequest(const Snapshot& snapshot, const RequestHandler::Query& query) const {
+			const TransportGraph& graph = GetRouter(snapshot).GetTransportGraph();
+			if (!snapshot.timetable_router) {
+				return std::nullopt; // no trips to ride
+			}
+			const std::optional<size_t> from_id = graph.FindStopVertexID(query.parameters.at(0));
+			const std::optional<size_t> to_id = graph.FindStopVertexID(query.parameters.at(1));
+			if (!from_id || !to_id) {
+				return std::nullopt;
 			}
-			return router_->GetShortestRoute(query.parameters.at(0), query.parameters.at(1));
+			return snapshot.timetable_router->FindEarliestArrival(*from_id, *to_id, query.values.at(0));
+		}
+
+		std::optional<std::vector<TransportRouter::RouteOption>> RequestHandler::RouteOptionsRequest(const Snapshot& snapshot, const RequestHandler::Query& query) const {
+			return GetRouter(snapshot).GetRouteOptions(query.parameters.at(0), query.parameters.at(1));
+		}
+
+		std::vector<std::vector<std::optional<double>>> RequestHandler::RouteMatrixRequest(const Snapshot& snapshot, const RequestHandler::Query& query) const {
+			// parameters hold the origins, then the destinations
+			const auto origins_end = query.parameters.begin() + query.counts.at(0);
+			std::vector<std::string_view> from(query.parameters.begin(), origins_end);
+			std::vector<std::string_view> to(origins_end, query.parameters.end());
+			return GetRouter(snapshot).GetRouteMatrix(from, to);
+		}
+
+		std::vector<std::optional<std::vector<TransportRouter::ReachableStop>>> RequestHandler::IsochroneRequests(const Snapshot& snapshot,
+			const std::vector<const RequestHandler::Query*>& queries) const {
+			const TransportRouter& router = GetRouter(snapshot);
+			std::vector<std::pair<std::string_view, double>> origins;
+			origins.reserve(queries.size());
+			for (const Query* query : queries) {
+				origins.emplace_back(query->parameters.at(0), query->values.at(0));
+			}
+			return router.GetReachableStops(origins);
+		}
+
+		std::vector<StopDistance> RequestHandler::NearestStopsRequest(const Snapshot& snapshot, const RequestHandler::Query& query) const {
+			return snapshot.catalogue->GetNearestStops({ query.values.at(0), query.values.at(1) }, query.counts.at(0));
+		}
+
+		std::vector<const domain::Stop*> RequestHandler::StopsInAreaRequest(const Snapshot& snapshot, const RequestHandler::Query& query) const {
+			return snapshot.catalogue->GetStopsInArea({ query.values.at(0), query.values.at(1) }, { query.values.at(2), query.values.at(3) });
 		}
 
 	}
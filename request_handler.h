@@ -2,6 +2,11 @@
 #include "transport_catalogue.h"
 #include "map_renderer.h"
 #include "transport_router.h"
+#include "timetable_router.h"
+#include "catalogue_snapshot.h"
+
+#include <functional>
+#include <mutex>
 
 namespace transport_catalogue {
 
@@ -9,15 +14,20 @@ namespace transport_catalogue {
 
 		using namespace std::literals;
 
+		// Loads the network through the setters below, then answers from snapshots: the first Pin() publishes
+		// the loaded network as version 0, and UpdateNetwork() and SetRouterSettings() publish changed copies
+		// while pinned snapshots keep answering. The other setters are for loading only, before the first Pin().
 		class RequestHandler
 		{
 		public:
 
 			struct Query {
-				enum class Type { STOP, BUS, MAP, ROUTE, UNDEFINED };
+				enum class Type { STOP, BUS, MAP, ROUTE, TIMETABLE_ROUTE, ROUTE_OPTIONS, ROUTE_MATRIX, ISOCHRONE, NEAREST_STOPS, STOPS_IN_AREA, UNDEFINED };
 				int id;
 				Type type;
 				std::vector<std::string> parameters;
+				std::vector<double> values = {}; // numeric parameters: coordinates and times
+				std::vector<size_t> counts = {}; // counts and list sizes
 			};
 
 		public:
@@ -39,15 +49,15 @@ namespace transport_catalogue {
 
 			const MapRenderer::Settings& GetRendererSettings() const;
 			
-			template <typename Settings>
-			void SetRouterSettings(Settings&& settings) {
-				router_ = std::make_unique<TransportRouter>(catalogue_, std::forward<Settings>(settings));
-			}
+			// while loading, the router is built or reweighted in place; once snapshots are answering, a reweighted
+			// copy of the current router is published as the next version and the pinned ones keep theirs
+			void SetRouterSettings(const TransportGraph::Settings& settings);
 
 			/* for serialization */
 			template <typename Graph, typename RouterInternalData>
 			void SetRouter(Graph&& graph, RouterInternalData&& router_data) {
-				router_ = std::make_unique<TransportRouter>(std::forward<Graph>(graph), std::forward<RouterInternalData>(router_data));
+				router_ = std::make_shared<TransportRouter>(catalogue_, std::forward<Graph>(graph), std::forward<RouterInternalData>(router_data));
+				UpdateTimetableRouter();
 			}
 
 			const TransportRouter& GetRouter() const {
@@ -58,18 +68,43 @@ namespace transport_catalogue {
 			}
 			/* ----------------- */
 
+			void SetTimetable(Timetable timetable);
+			const Timetable& GetTimetable() const;
+
+			// the current snapshot, for the thread answering requests; a guard per batch keeps its answers consistent
+			SnapshotStore::Guard Pin();
+			// copies the current catalogue and router, applies the change to both and publishes them; may run on
+			// another thread once the first Pin() is done
+			void UpdateNetwork(const std::function<void(NetworkEdit&)>& change);
+
 			const std::vector<Query>& GetRequests() const;
-			std::optional<std::set<std::string_view>> InfoStopRequest(const Query& query) const;
-			std::optional<domain::BusInfo> InfoBusRequest(const Query& query) const;
-			std::set<domain::Bus> AllBusesRequest() const;
-			void DrawMapRequest(std::ostream& out) const;
-			std::optional<TransportRouter::TransportRouteInfo> GetShortestRouteRequest(const Query& query) const;
+			std::optional<StopBusesView> InfoStopRequest(const Snapshot& snapshot, const Query& query) const;
+			std::optional<domain::BusInfo> InfoBusRequest(const Snapshot& snapshot, const Query& query) const;
+			std::set<domain::Bus> AllBusesRequest(const Snapshot& snapshot) const;
+			void DrawMapRequest(const Snapshot& snapshot, std::ostream& out) const;
+			std::optional<TransportRouter::TransportRouteInfo> GetShortestRouteRequest(const Snapshot& snapshot, const Query& query) const;
+			std::optional<TimetableRouter::Journey> TimetableRouteRequest(const Snapshot& snapshot, const Query& query) const;
+			std::optional<std::vector<TransportRouter::RouteOption>> RouteOptionsRequest(const Snapshot& snapshot, const Query& query) const;
+			std::vector<std::vector<std::optional<double>>> RouteMatrixRequest(const Snapshot& snapshot, const Query& query) const;
+			std::vector<std::optional<std::vector<TransportRouter::ReachableStop>>> IsochroneRequests(const Snapshot& snapshot,
+				const std::vector<const Query*>& queries) const; // one batch, searched in parallel
+			std::vector<StopDistance> NearestStopsRequest(const Snapshot& snapshot, const Query& query) const;
+			std::vector<const domain::Stop*> StopsInAreaRequest(const Snapshot& snapshot, const Query& query) const;
 
 		private:	
 			const TransportCatalogue& catalogue_;
 			std::vector<Query> requests_ = {};
 			std::unique_ptr<MapRenderer> renderer_;
-			std::unique_ptr<TransportRouter> router_;
+			std::shared_ptr<TransportRouter> router_; // shared with the first snapshot
+			Timetable timetable_;
+			std::shared_ptr<TimetableRouter> timetable_router_; // only with both a router and a timetable
+
+			std::unique_ptr<SnapshotStore> snapshots_; // created by the first Pin()
+			std::optional<SnapshotStore::Reader> reader_; // the answering thread's
+			std::mutex update_mutex_; // one update or reweighting copies and edits at a time
+
+			void UpdateTimetableRouter();
+			static const TransportRouter& GetRouter(const Snapshot& snapshot);
 		};
 
 	}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace transport_catalogue {
+
+	// The weight of the routing graph and of everything precomputed over it. Minutes by default; built with
+	// TRANSPORT_FIXED_POINT_WEIGHTS, whole units of 2^-32 minute in int64_t, summed exactly.
+	// Either way every edge weight is rounded once to a multiple of 2^-32 minute (about 14 ns). Sums of such
+	// doubles are exact below 2^21 minutes, so both builds choose the same routes and print the same times.
+	// Times leave the router in minutes either way.
+#ifdef TRANSPORT_FIXED_POINT_WEIGHTS
+	using RouteWeight = int64_t;
+#else
+	using RouteWeight = double;
+#endif
+
+	constexpr int WEIGHT_FRACTION_BITS = 32;
+
+	// rounded to the nearest 2^-32 minute; integer times beyond the range saturate
+	template <typename Weight>
+	Weight ToWeight(double minutes) {
+		if constexpr (std::is_integral_v<Weight>) {
+			const double units = std::round(std::ldexp(minutes, WEIGHT_FRACTION_BITS));
+			if (units >= static_cast<double>(std::numeric_limits<Weight>::max())) {
+				return std::numeric_limits<Weight>::max();
+			}
+			return static_cast<Weight>(units);
+		}
+		else {
+			// from 2^20 minutes on a double has no bits below 2^-32 left to round, infinity included
+			if (!(std::abs(minutes) < 0x1p20)) {
+				return static_cast<Weight>(minutes);
+			}
+			return static_cast<Weight>(std::ldexp(std::round(std::ldexp(minutes, WEIGHT_FRACTION_BITS)), -WEIGHT_FRACTION_BITS));
+		}
+	}
+
+	template <typename Weight>
+	double ToMinutes(Weight weight) {
+		if constexpr (std::is_integral_v<Weight>) {
+			return std::ldexp(static_cast<double>(weight), -WEIGHT_FRACTION_BITS);
+		}
+		else {
+			return static_cast<double>(weight);
+		}
+	}
+
+	inline RouteWeight ToRouteWeight(double minutes) {
+		return ToWeight<RouteWeight>(minutes);
+	}
+}
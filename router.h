@@ -1,11 +1,13 @@
 #pragma once
 
+#include "components.h"
 #include "graph.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <iterator>
+#include <limits>
 #include <optional>
 #include <stdexcept>
 #include <unordered_map>
@@ -14,28 +16,49 @@
 
 namespace graph {
 
+    // All-pairs routes, stored block-diagonally: when every strongly connected component is closed, no route
+    // leaves its component, so a row holds the routes within the component of its vertex only. Otherwise
+    // the whole graph is one block.
     template <typename Weight>
     class Router {
     private:
         using Graph = DirectedWeightedGraph<Weight>;
 
     public:
+        // the last edge of a route, or NO_EDGE for the empty route; 32 bits keep a table cell small
+        static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+
         struct RouteInternalData {
             Weight weight;
-            std::optional<EdgeId> prev_edge;
+            uint32_t prev_edge = NO_EDGE;
         };
-        using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+        using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>; // by vertex, then by index in block
 
         explicit Router(const Graph& graph);
+        // the routes of other over graph, a copy of its graph
+        Router(const Graph& graph, const Router& other)
+            : graph_(graph)
+            , routes_internal_data_(other.routes_internal_data_)
+            , blocks_(other.blocks_)
+            , block_by_vertex_(other.block_by_vertex_)
+            , index_in_block_(other.index_in_block_) {
+        }
 
         /* for serialization */ 
         template <typename RoutesInternalDataType>
         explicit Router(const Graph& graph, RoutesInternalDataType&& data)
             : graph_(graph)
             , routes_internal_data_(std::forward<RoutesInternalDataType>(data))
-            
         {
-            
+            SplitIntoBlocks();
+            if (routes_internal_data_.size() != graph_.GetVertexCount()) {
+                throw std::invalid_argument("Routes do not match the blocks of the graph");
+            }
+            for (VertexId vertex = 0; vertex < routes_internal_data_.size(); ++vertex) {
+                if (routes_internal_data_[vertex].size() != blocks_[block_by_vertex_[vertex]].size()) {
+                    throw std::invalid_argument("Routes do not match the blocks of the graph");
+                }
+            }
         }
 
         const RoutesInternalData& GetRoutesInternalData() const {
@@ -43,6 +66,18 @@ namespace graph {
         }
         /* ------------------ */
 
+        // empty for a vertex of another block, without looking at the table
+        const std::optional<RouteInternalData>& GetRouteInternalData(VertexId from, VertexId to) const {
+            if (block_by_vertex_[from] != block_by_vertex_[to]) {
+                return NO_ROUTE;
+            }
+            return routes_internal_data_[from][index_in_block_[to]];
+        }
+
+        size_t GetBlockCount() const {
+            return blocks_.size();
+        }
+
         struct RouteInfo {
             Weight weight;
             std::vector<EdgeId> edges;
@@ -50,19 +85,44 @@ namespace graph {
 
         std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+        // recomputes all routes after edges of the graph were changed or removed
+        void Rebuild();
+        // repairs the routes after edges [first, last) were added or got lighter, touching only improved pairs
+        void UpdateWithEdges(EdgeId first, EdgeId last);
+
     private:
+        // callers pass two vertices of one block
+        std::optional<RouteInternalData>& GetRoute(VertexId from, VertexId to) {
+            return routes_internal_data_[from][index_in_block_[to]];
+        }
+
+        void SplitIntoBlocks() {
+            const size_t vertex_count = graph_.GetVertexCount();
+            const Components components = FindStronglyConnectedComponents(graph_);
+            const bool is_split = components.AreAllClosed();
+            blocks_.assign(is_split ? components.GetCount() : std::min<size_t>(vertex_count, 1), {});
+            block_by_vertex_.resize(vertex_count);
+            index_in_block_.resize(vertex_count);
+            for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+                const uint32_t block = is_split ? components.component_by_vertex[vertex] : 0;
+                block_by_vertex_[vertex] = block;
+                index_in_block_[vertex] = static_cast<uint32_t>(blocks_[block].size());
+                blocks_[block].push_back(vertex);
+            }
+        }
+
         void InitializeRoutesInternalData(const Graph& graph) {
             const size_t vertex_count = graph.GetVertexCount();
             for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-                routes_internal_data_[vertex][vertex] = RouteInternalData{ ZERO_WEIGHT, std::nullopt };
+                GetRoute(vertex, vertex) = RouteInternalData{ ZERO_WEIGHT, NO_EDGE };
                 for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                     const auto& edge = graph.GetEdge(edge_id);
                     if (edge.weight < ZERO_WEIGHT) {
                         throw std::domain_error("Edges' weights should be non-negative");
                     }
-                    auto& route_internal_data = routes_internal_data_[vertex][edge.to];
+                    auto& route_internal_data = GetRoute(vertex, edge.to);
                     if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                        route_internal_data = RouteInternalData{ edge.weight, edge_id };
+                        route_internal_data = RouteInternalData{ edge.weight, static_cast<uint32_t>(edge_id) };
                     }
                 }
             }
@@ -70,19 +130,19 @@ namespace graph {
 
         void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
             const RouteInternalData& route_to) {
-            auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
+            auto& route_relaxing = GetRoute(vertex_from, vertex_to);
             const Weight candidate_weight = route_from.weight + route_to.weight;
             if (!route_relaxing || candidate_weight < route_relaxing->weight) {
                 route_relaxing = { candidate_weight,
-                                  route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge };
+                                  route_to.prev_edge != NO_EDGE ? route_to.prev_edge : route_from.prev_edge };
             }
         }
 
-        void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-            for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-                if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                    for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                        if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
+        void RelaxRoutesInternalDataThroughVertex(const std::vector<VertexId>& block, VertexId vertex_through) {
+            for (VertexId vertex_from : block) {
+                if (const auto& route_from = GetRoute(vertex_from, vertex_through)) {
+                    for (VertexId vertex_to : block) {
+                        if (const auto& route_to = GetRoute(vertex_through, vertex_to)) {
                             RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
                         }
                     }
@@ -91,38 +151,106 @@ namespace graph {
         }
 
         static constexpr Weight ZERO_WEIGHT{};
+        static inline const std::optional<RouteInternalData> NO_ROUTE{};
         const Graph& graph_;
         RoutesInternalData routes_internal_data_;
+        std::vector<std::vector<VertexId>> blocks_;
+        std::vector<uint32_t> block_by_vertex_;
+        std::vector<uint32_t> index_in_block_;
     };
 
     template <typename Weight>
     Router<Weight>::Router(const Graph& graph)
         : graph_(graph)
-        , routes_internal_data_(graph.GetVertexCount(),
-            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
     {
-        InitializeRoutesInternalData(graph);
+        Rebuild();
+    }
 
-        const size_t vertex_count = graph.GetVertexCount();
-        for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-            RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+    template <typename Weight>
+    void Router<Weight>::Rebuild() {
+        if (graph_.GetEdgeCount() >= NO_EDGE) {
+            throw std::length_error("Too many edges for the route table");
+        }
+        SplitIntoBlocks();
+        const size_t vertex_count = graph_.GetVertexCount();
+        routes_internal_data_.resize(vertex_count);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            routes_internal_data_[vertex].assign(blocks_[block_by_vertex_[vertex]].size(), std::nullopt);
+            routes_internal_data_[vertex].shrink_to_fit();
+        }
+        InitializeRoutesInternalData(graph_);
+
+        for (const std::vector<VertexId>& block : blocks_) {
+            for (VertexId vertex_through : block) {
+                RelaxRoutesInternalDataThroughVertex(block, vertex_through);
+            }
+        }
+    }
+
+    template <typename Weight>
+    void Router<Weight>::UpdateWithEdges(EdgeId first, EdgeId last) {
+        if (last >= NO_EDGE) {
+            throw std::length_error("Too many edges for the route table");
+        }
+        std::vector<VertexId> rows;
+        std::vector<VertexId> cols;
+        for (EdgeId edge_id = first; edge_id < last; ++edge_id) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            if (block_by_vertex_[edge.from] != block_by_vertex_[edge.to]) {
+                Rebuild(); // the edge joins two blocks
+                return;
+            }
+            const std::vector<VertexId>& block = blocks_[block_by_vertex_[edge.from]];
+            const RouteInternalData via_edge{ edge.weight, static_cast<uint32_t>(edge_id) };
+
+            // a new shortest path uses the edge at most once: from -> edge.from -> edge.to -> to,
+            // and only sources reaching edge.to faster and targets reached from edge.from faster can gain
+            rows.clear();
+            for (VertexId vertex_from : block) {
+                const auto& to_edge = GetRoute(vertex_from, edge.from);
+                const auto& current = GetRoute(vertex_from, edge.to);
+                if (to_edge && (!current || to_edge->weight + edge.weight < current->weight)) {
+                    rows.push_back(vertex_from);
+                }
+            }
+            cols.clear();
+            for (VertexId vertex_to : block) {
+                const auto& from_edge = GetRoute(edge.to, vertex_to);
+                const auto& current = GetRoute(edge.from, vertex_to);
+                if (from_edge && (!current || edge.weight + from_edge->weight < current->weight)) {
+                    cols.push_back(vertex_to);
+                }
+            }
+
+            for (VertexId vertex_from : rows) {
+                const RouteInternalData to_edge = *GetRoute(vertex_from, edge.from);
+                for (VertexId vertex_to : cols) {
+                    const RouteInternalData& from_edge = *GetRoute(edge.to, vertex_to);
+                    RouteInternalData route_to{ edge.weight + from_edge.weight,
+                                                from_edge.prev_edge != NO_EDGE ? from_edge.prev_edge : via_edge.prev_edge };
+                    RelaxRoute(vertex_from, vertex_to, to_edge, route_to);
+                }
+            }
         }
     }
 
     template <typename Weight>
     std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
         VertexId to) const {
-        const auto& route_internal_data = routes_internal_data_.at(from).at(to);
+        const auto& route_internal_data = GetRouteInternalData(from, to);
         if (!route_internal_data) {
             return std::nullopt;
         }
         const Weight weight = route_internal_data->weight;
         std::vector<EdgeId> edges;
-        for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-            edge_id;
-            edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+        for (uint32_t edge_id = route_internal_data->prev_edge;
+            edge_id != NO_EDGE;
+            edge_id = GetRouteInternalData(from, graph_.GetEdge(edge_id).from)->prev_edge)
         {
-            edges.push_back(*edge_id);
+            edges.push_back(edge_id);
         }
         std::reverse(edges.begin(), edges.end());
 
@@ -33,6 +33,7 @@ namespace transport_catalogue {
 			: catalog_(catalog)
 			, map_settings_(handler.GetRendererSettings())
 			, router_(handler.GetRouter())
+			, timetable_(handler.GetTimetable())
 			, file_(path) 
 		{
 
@@ -58,7 +59,7 @@ namespace transport_catalogue {
 		/* TransportCatalogue */
 		ProtoStop Serializator::SerializeStop(const Stop& stop) {
 			ProtoStop proto_stop;
-			proto_stop.set_stop(stop.stop);
+			proto_stop.set_stop(std::string(stop.stop));
 			proto_stop.mutable_coords()->set_lat(stop.coords.lat);
 			proto_stop.mutable_coords()->set_lng(stop.coords.lng);
 			stop_table_[stop.stop] = static_cast<uint32_t>(stop_table_.size());
@@ -67,13 +68,18 @@ namespace transport_catalogue {
 
 		ProtoBus Serializator::SerializeBus(const Bus& bus) {
 			ProtoBus proto_bus;
-			proto_bus.set_bus(bus.bus);
+			proto_bus.set_bus(std::string(bus.bus));
 			proto_bus.set_is_circle(bus.is_circle);
 
-			for (const Stop* stop : bus.route) {
-				uint32_t number = stop_table_.at(stop->stop);
+			for (uint32_t stop_id : bus.route) {
+				uint32_t number = stop_table_.at(catalog_.GetStopByID(stop_id).stop);
 				proto_bus.add_route(number);
 			}
+			if (auto it = timetable_.find(bus.bus); it != timetable_.end()) {
+				for (double departure : it->second) {
+					proto_bus.add_departures(departure);
+				}
+			}
 			bus_table_[bus.bus] = static_cast<uint32_t>(bus_table_.size());
 			return proto_bus;
 
@@ -150,7 +156,7 @@ namespace transport_catalogue {
 				::graph_serialize::Edge proto_edge;
 				proto_edge.set_from(edge.from);
 				proto_edge.set_to(edge.to);
-				proto_edge.set_weight(edge.weight);
+				proto_edge.set_weight(ToMinutes(edge.weight));
 				*proto_graph.add_edges() = std::move(proto_edge);
 			}
 
@@ -162,12 +168,22 @@ namespace transport_catalogue {
 			const auto& settings = router_.GetTransportGraph().GetSettings();
 			proto_settings.set_velocity(settings.velocity);
 			proto_settings.set_wait_time(settings.wait_time);
+			// the proto enum lists the engines in the same order
+			proto_settings.set_engine(static_cast<::transport_router_serialize::Settings_Engine>(settings.engine));
+			proto_settings.set_landmark_count(static_cast<uint32_t>(settings.landmark_count));
+			proto_settings.set_tree_cache_size(static_cast<uint32_t>(settings.tree_cache_size));
+			proto_settings.set_max_router_memory_mb(static_cast<uint32_t>(settings.max_router_memory_mb));
+			for (const std::string& stop : settings.frequent_stops) {
+				proto_settings.add_frequent_stops(stop);
+			}
+			proto_settings.set_vertex_order(static_cast<::transport_router_serialize::Settings_VertexOrder>(settings.vertex_order));
 			return proto_settings;
 		}
 
 		ProtoRouteSegment Serializator::SerializeRouteSegment(const RouteSegment& segment) const {
 			ProtoRouteSegment proto_segment;
 			proto_segment.set_time(segment.time);
+			proto_segment.set_distance(segment.distance);
 			switch (segment.type) {
 			case RouteSegment::Type::BUS:
 			{
@@ -198,7 +214,7 @@ namespace transport_catalogue {
 			*proto_graph.mutable_settings() = SerializeRouterSettings();
 
 			for (const Stop& stop : catalog_.GetAllStops()) {
-				proto_graph.mutable_id_by_stops_()->insert({stop_table_.at(stop.stop), graph_.GetBeforeWaitingStopID(stop.stop) / 2 });				
+				proto_graph.mutable_id_by_stops_()->insert({stop_table_.at(stop.stop), graph_.GetStopVertexID(stop.stop) });				
 			}
 
 			for (int seg = 0; seg < graph_.GetSegmentCount(); ++seg) {
@@ -210,9 +226,9 @@ namespace transport_catalogue {
 		ProtoOptionalRouteInternalData Serializator::SerializeOptionalRouteInternalData(const std::optional<RouteInternalData>& data) const {
 			ProtoOptionalRouteInternalData optional_proto_data;
 			if (data) {
-				optional_proto_data.mutable_data()->set_weight(data->weight);
-				if (data->prev_edge) {
-					optional_proto_data.mutable_data()->mutable_prev_edge()->set_edge_id(*(data->prev_edge));
+				optional_proto_data.mutable_data()->set_weight(ToMinutes(data->weight));
+				if (data->prev_edge != Router::NO_EDGE) {
+					optional_proto_data.mutable_data()->mutable_prev_edge()->set_edge_id(data->prev_edge);
 				}
 			}
 			return optional_proto_data;
@@ -224,17 +240,75 @@ namespace transport_catalogue {
 
 			for (const std::vector<std::optional<RouteInternalData>>& line : router.GetRoutesInternalData()) {
 				auto ptr_routes_internal_data_line = proto_inner_router.add_routes_internal_data();
-				for (const std::optional<graph::Router<double>::RouteInternalData>& data : line) {
+				for (const std::optional<graph::Router<RouteWeight>::RouteInternalData>& data : line) {
 					*ptr_routes_internal_data_line->add_items() = SerializeOptionalRouteInternalData(data);
 				}
 			}
 			return proto_inner_router;
 		}
 
+		ProtoLandmarks Serializator::SerializeLandmarks() const {
+			const AltRouter::Landmarks& landmarks = router_.GetAltRouter().GetLandmarks();
+			ProtoLandmarks proto_landmarks;
+			for (graph::VertexId vertex : landmarks.vertices) {
+				proto_landmarks.add_vertices(static_cast<uint32_t>(vertex));
+			}
+			for (RouteWeight weight : landmarks.from_landmark) {
+				proto_landmarks.add_from_landmark(ToMinutes(weight));
+			}
+			for (RouteWeight weight : landmarks.to_landmark) {
+				proto_landmarks.add_to_landmark(ToMinutes(weight));
+			}
+			return proto_landmarks;
+		}
+
+		ProtoLabels Serializator::SerializeLabels(const std::vector<size_t>& offsets,
+			const std::vector<HubLabels::LabelEntry>& entries) const {
+			ProtoLabels proto_labels;
+			for (size_t vertex = 0; vertex + 1 < offsets.size(); ++vertex) {
+				proto_labels.add_sizes(static_cast<uint32_t>(offsets[vertex + 1] - offsets[vertex]));
+				uint32_t previous_hub = 0;
+				for (size_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+					const HubLabels::LabelEntry& entry = entries[i];
+					// ranks grow along a label, small gaps make short varints
+					proto_labels.add_hubs(entry.hub - previous_hub);
+					previous_hub = entry.hub;
+					proto_labels.add_weights(ToMinutes(entry.weight));
+					proto_labels.add_edges(entry.edge == HubLabels::NO_EDGE ? 0 : static_cast<uint32_t>(entry.edge + 1));
+				}
+			}
+			return proto_labels;
+		}
+
+		ProtoHubLabels Serializator::SerializeHubLabels() const {
+			const HubLabels::Labels& labels = router_.GetHubLabels().GetLabels();
+			ProtoHubLabels proto_hub_labels;
+			for (graph::VertexId vertex : labels.vertex_by_rank) {
+				proto_hub_labels.add_vertex_by_rank(static_cast<uint32_t>(vertex));
+			}
+			*proto_hub_labels.mutable_out_labels() = SerializeLabels(labels.out_offsets, labels.out_entries);
+			*proto_hub_labels.mutable_in_labels() = SerializeLabels(labels.in_offsets, labels.in_entries);
+			return proto_hub_labels;
+		}
+
 		ProtoTransportRouter Serializator::SerializeTransportRouter() const {
 			ProtoTransportRouter proto_router;
 			*proto_router.mutable_transport_graph() = SerializeTransportGraph();
-			*proto_router.mutable_router() = SerializeInnerRouter();			
+			switch (router_.GetTransportGraph().GetSettings().engine) {
+			case RouteEngine::TRANSFER_TABLE:
+				if (router_.HasInnerRouter()) {
+					*proto_router.mutable_router() = SerializeInnerRouter();
+				}
+				break; // the pinned rows of a table over the budget are recomputed on load
+			case RouteEngine::ALT:
+				*proto_router.mutable_landmarks() = SerializeLandmarks();
+				break;
+			case RouteEngine::HUB_LABELS:
+				*proto_router.mutable_hub_labels() = SerializeHubLabels();
+				break;
+			case RouteEngine::RAPTOR:
+				break; // nothing precomputed
+			}
 			return proto_router;
 		}
 
@@ -279,35 +353,51 @@ namespace transport_catalogue {
 			return Stop{ proto_stop.stop(), { proto_stop.coords().lat(), proto_stop.coords().lng() } };
 		}
 
-		Bus Deserializator::DeserializeBus(const ProtoBus& proto_bus) const {
-			Bus bus{ proto_bus.bus(), {}, proto_bus.is_circle() };
-			bus.route.reserve(proto_bus.route_size());
-			for (int i = 0; i < proto_bus.route_size(); ++i) {
-				uint32_t stop_number = proto_bus.route(i);
-				std::string stop_name = proto_content_.catalog().stops(stop_number).stop();
-				bus.route.emplace_back(*catalog_.FindStopByName(stop_name));
-			}
-			return bus;
+		void Deserializator::DeserializeBus(TransportCatalogue::BulkLoader& loader, const ProtoBus& proto_bus) const {
+			// stops are restored in their serialized order, so a stop number is its ID
+			std::vector<uint32_t> route(proto_bus.route().begin(), proto_bus.route().end());
+			loader.AddBus(proto_bus.bus(), route, proto_bus.is_circle());
 		}
 
-		void Deserializator::DeserializeDistances() {
+		void Deserializator::DeserializeDistances(TransportCatalogue::BulkLoader& loader) const {
 			for (int i = 0; i < proto_content_.catalog().distances_size(); ++i) {
 				const ProtoDistance& proto_distance = proto_content_.catalog().distances(i);
-				std::string from = proto_content_.catalog().stops(proto_distance.from_stop()).stop();
-				std::string to = proto_content_.catalog().stops(proto_distance.to_stop()).stop();
-				catalog_.SetDistance(from, to, proto_distance.distance());
+				loader.AddDistance(proto_distance.from_stop(), proto_distance.to_stop(), proto_distance.distance());
 			}
 		}
 
 		void Deserializator::DeserializeCatalogue() {
-			for (int i = 0; i < proto_content_.catalog().stops_size(); ++i) {
-				catalog_.AddStop(DeserializeStop(proto_content_.catalog().stops(i)));
+			const ProtoTransportCatalogue& proto_catalog = proto_content_.catalog();
+			size_t route_stop_count = 0;
+			for (int i = 0; i < proto_catalog.buses_size(); ++i) {
+				route_stop_count += proto_catalog.buses(i).route_size();
 			}
 
-			for (int i = 0; i < proto_content_.catalog().buses_size(); ++i) {
-				catalog_.AddBus(DeserializeBus(proto_content_.catalog().buses(i)));
+			TransportCatalogue::BulkLoader loader(catalog_);
+			loader.Reserve(proto_catalog.stops_size(), proto_catalog.buses_size(), route_stop_count, proto_catalog.distances_size());
+
+			for (int i = 0; i < proto_catalog.stops_size(); ++i) {
+				loader.AddStop(DeserializeStop(proto_catalog.stops(i)));
+			}
+
+			for (int i = 0; i < proto_catalog.buses_size(); ++i) {
+				DeserializeBus(loader, proto_catalog.buses(i));
+			}
+			DeserializeDistances(loader);
+			loader.Finalize();
+
+			// before the router, which builds the timetable router on top of it
+			Timetable timetable;
+			for (int i = 0; i < proto_catalog.buses_size(); ++i) {
+				const ProtoBus& proto_bus = proto_catalog.buses(i);
+				if (proto_bus.departures_size() > 0) {
+					timetable[catalog_.FindBusByName(proto_bus.bus()).value()->bus].assign(
+						proto_bus.departures().begin(), proto_bus.departures().end());
+				}
+			}
+			if (!timetable.empty()) {
+				handler_.SetTimetable(std::move(timetable));
 			}
-			DeserializeDistances();
 		}
 
 
@@ -371,17 +461,23 @@ namespace transport_catalogue {
 
 		TransportGraph::Settings Deserializator::DeserializeRouterSettings() const {
 			const auto& proto_settings = proto_content_.transport_router().transport_graph().settings();
-			return { proto_settings.wait_time(), proto_settings.velocity() };
+			return { proto_settings.wait_time(), proto_settings.velocity(),
+				static_cast<RouteEngine>(proto_settings.engine()),
+				proto_settings.landmark_count(),
+				proto_settings.tree_cache_size(),
+				proto_settings.max_router_memory_mb(),
+				{ proto_settings.frequent_stops().begin(), proto_settings.frequent_stops().end() },
+				static_cast<VertexOrder>(proto_settings.vertex_order()) };
 		}
 
 		Graph Deserializator::DeserializeInnerGraph() const {
 			const auto& proto_graph = proto_content_.transport_router().transport_graph().graph();
-			graph::DirectedWeightedGraph<double> graph(catalog_.GetAllStops().size() * 2);
+			graph::DirectedWeightedGraph<RouteWeight> graph(catalog_.GetAllStops().size());
 			
 			for (int edge_id = 0; edge_id < proto_graph.edges_size(); ++edge_id) {
-				graph::Edge<double> edge{ proto_graph.edges(edge_id).from(),
+				graph::Edge<RouteWeight> edge{ proto_graph.edges(edge_id).from(),
 					proto_graph.edges(edge_id).to(),
-					proto_graph.edges(edge_id).weight() };
+					ToRouteWeight(proto_graph.edges(edge_id).weight()) };
 				graph.AddEdge(edge);				
 			}
 
@@ -391,6 +487,7 @@ namespace transport_catalogue {
 		RouteSegment Deserializator::DeserializeRouteSegment(const ProtoRouteSegment& proto_segment) const {
 			RouteSegment segment;
 			segment.time = proto_segment.time();
+			segment.distance = proto_segment.distance();
 
 			switch (proto_segment.type()) {
 			case ::transport_router_serialize::RouteSegment_Type_BUS:
@@ -434,10 +531,10 @@ namespace transport_catalogue {
 
 		std::optional<RouteInternalData> Deserializator::DeserializeOptionalRouteInternalData(const ProtoOptionalRouteInternalData& optional_proto_data) const {
 			if (optional_proto_data.has_data()) {
-				graph::Router<double>::RouteInternalData data;
-				data.weight = optional_proto_data.data().weight();
+				graph::Router<RouteWeight>::RouteInternalData data;
+				data.weight = ToRouteWeight(optional_proto_data.data().weight());
 				if (optional_proto_data.data().has_prev_edge()) {
-					data.prev_edge = optional_proto_data.data().prev_edge().edge_id();
+					data.prev_edge = static_cast<uint32_t>(optional_proto_data.data().prev_edge().edge_id());
 				}
 				return data;
 			}
@@ -463,8 +560,60 @@ namespace transport_catalogue {
 			return routes_internal_data;
 		}
 
+		AltRouter::Landmarks Deserializator::DeserializeLandmarks() const {
+			const ProtoLandmarks& proto_landmarks = proto_content_.transport_router().landmarks();
+			AltRouter::Landmarks landmarks;
+			landmarks.vertices.assign(proto_landmarks.vertices().begin(), proto_landmarks.vertices().end());
+			landmarks.from_landmark.reserve(proto_landmarks.from_landmark_size());
+			for (double minutes : proto_landmarks.from_landmark()) {
+				landmarks.from_landmark.push_back(ToRouteWeight(minutes));
+			}
+			landmarks.to_landmark.reserve(proto_landmarks.to_landmark_size());
+			for (double minutes : proto_landmarks.to_landmark()) {
+				landmarks.to_landmark.push_back(ToRouteWeight(minutes));
+			}
+			return landmarks;
+		}
+
+		void Deserializator::DeserializeLabels(const ProtoLabels& proto_labels, std::vector<size_t>& offsets,
+			std::vector<HubLabels::LabelEntry>& entries) const {
+			offsets.assign(1, 0);
+			entries.clear();
+			entries.reserve(proto_labels.hubs_size());
+			int i = 0;
+			for (uint32_t size : proto_labels.sizes()) {
+				uint32_t hub = 0;
+				for (uint32_t k = 0; k < size; ++k, ++i) {
+					hub += proto_labels.hubs(i);
+					const uint32_t edge = proto_labels.edges(i);
+					entries.push_back({ hub, ToRouteWeight(proto_labels.weights(i)), edge == 0 ? HubLabels::NO_EDGE : graph::EdgeId{ edge - 1 } });
+				}
+				offsets.push_back(entries.size());
+			}
+		}
+
+		HubLabels::Labels Deserializator::DeserializeHubLabels() const {
+			const ProtoHubLabels& proto_hub_labels = proto_content_.transport_router().hub_labels();
+			HubLabels::Labels labels;
+			labels.vertex_by_rank.assign(proto_hub_labels.vertex_by_rank().begin(), proto_hub_labels.vertex_by_rank().end());
+			DeserializeLabels(proto_hub_labels.out_labels(), labels.out_offsets, labels.out_entries);
+			DeserializeLabels(proto_hub_labels.in_labels(), labels.in_offsets, labels.in_entries);
+			return labels;
+		}
+
 		void Deserializator::DeserializeTransportRouter() {
-			handler_.SetRouter(DeserializeTransportGraph(), DeserializeInnerRouterData());
+			if (proto_content_.transport_router().has_landmarks()) {
+				handler_.SetRouter(DeserializeTransportGraph(), DeserializeLandmarks());
+			}
+			else if (proto_content_.transport_router().has_hub_labels()) {
+				handler_.SetRouter(DeserializeTransportGraph(), DeserializeHubLabels());
+			}
+			else if (!proto_content_.transport_router().has_router()) {
+				handler_.SetRouter(DeserializeTransportGraph(), std::nullopt);
+			}
+			else {
+				handler_.SetRouter(DeserializeTransportGraph(), DeserializeInnerRouterData());
+			}
 		}
 	}
 }
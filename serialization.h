@@ -22,15 +22,20 @@ namespace transport_catalogue {
 
 		using ProtoGraph = ::graph_serialize::Graph;
 		using ProtoRouter = ::graph_serialize::Router;
+		using ProtoLandmarks = ::graph_serialize::Landmarks;
+		using ProtoLabels = ::graph_serialize::Labels;
+		using ProtoHubLabels = ::graph_serialize::HubLabels;
 		using ProtoOptionalRouteInternalData = ::graph_serialize::OptionalRouteInternalData;
 		using ProtoTransportRouter = ::transport_router_serialize::TransportRouter;
 		using ProtoTransportRouterSettings = ::transport_router_serialize::Settings;
 		using ProtoTransportGraph = ::transport_router_serialize::TransportGraph;
 		using ProtoRouteSegment = ::transport_router_serialize::RouteSegment;
 
-		using Graph = graph::DirectedWeightedGraph<double>;
-		using Router = graph::Router<double>;
+		using Graph = graph::DirectedWeightedGraph<RouteWeight>;
+		using Router = graph::Router<RouteWeight>;
 		using RouteInternalData = Router::RouteInternalData;
+		using AltRouter = graph::AltRouter<RouteWeight>;
+		using HubLabels = graph::HubLabels<RouteWeight>;
 
 		class Serializator {
 		public:
@@ -41,6 +46,7 @@ namespace transport_catalogue {
 			const TransportCatalogue& catalog_;
 			const MapRenderer::Settings& map_settings_;
 			const TransportRouter& router_;
+			const Timetable& timetable_;
 			std::filesystem::path file_;
 			NumberTable stop_table_;
 			NumberTable bus_table_;
@@ -59,6 +65,9 @@ namespace transport_catalogue {
 			ProtoRouteSegment SerializeRouteSegment(const RouteSegment& segment) const;
 			ProtoTransportGraph SerializeTransportGraph() const;
 			ProtoRouter SerializeInnerRouter() const;
+			ProtoLandmarks SerializeLandmarks() const;
+			ProtoLabels SerializeLabels(const std::vector<size_t>& offsets, const std::vector<HubLabels::LabelEntry>& entries) const;
+			ProtoHubLabels SerializeHubLabels() const;
 			ProtoOptionalRouteInternalData SerializeOptionalRouteInternalData(const std::optional<RouteInternalData>& data) const;
 			ProtoTransportRouter SerializeTransportRouter() const;
 			
@@ -76,8 +85,8 @@ namespace transport_catalogue {
 			::transport_catalogue_serialize::AllContent proto_content_;
 
 			Stop DeserializeStop(const ProtoStop& proto_stop) const;
-			Bus DeserializeBus(const ProtoBus& proto_bus) const;
-			void DeserializeDistances();
+			void DeserializeBus(TransportCatalogue::BulkLoader& loader, const ProtoBus& proto_bus) const;
+			void DeserializeDistances(TransportCatalogue::BulkLoader& loader) const;
 			void DeserializeCatalogue();
 
 			svg::Point DeserializePoint(const ProtoPoint& proto_point) const;
@@ -89,6 +98,10 @@ namespace transport_catalogue {
 			RouteSegment DeserializeRouteSegment(const ProtoRouteSegment& proto_segment) const;
 			TransportGraph DeserializeTransportGraph() const;
 			Router::RoutesInternalData DeserializeInnerRouterData() const;
+			AltRouter::Landmarks DeserializeLandmarks() const;
+			void DeserializeLabels(const ProtoLabels& proto_labels, std::vector<size_t>& offsets,
+				std::vector<HubLabels::LabelEntry>& entries) const;
+			HubLabels::Labels DeserializeHubLabels() const;
 			std::optional<RouteInternalData> DeserializeOptionalRouteInternalData(const ProtoOptionalRouteInternalData& optional_proto_data) const;
 			void DeserializeTransportRouter();
 		};
@@ -0,0 +1,230 @@
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <limits>
+#include <queue>
+
+namespace transport_catalogue {
+
+	using namespace domain;
+
+	namespace {
+		const double STOPS_PER_CELL = 2.0;
+		const double MIN_SPAN = 1e-9;
+		const double DEG_TO_RAD = M_PI / 180.;
+	}
+
+	SpatialIndex::SpatialIndex(const std::deque<Stop>& stops)
+		: stops_(&stops) {
+		if (stops.empty()) {
+			return;
+		}
+
+		double max_lat = stops.front().coords.lat;
+		double max_lng = stops.front().coords.lng;
+		min_lat_ = max_lat;
+		min_lng_ = max_lng;
+		for (const Stop& stop : stops) {
+			min_lat_ = std::min(min_lat_, stop.coords.lat);
+			max_lat = std::max(max_lat, stop.coords.lat);
+			min_lng_ = std::min(min_lng_, stop.coords.lng);
+			max_lng = std::max(max_lng, stop.coords.lng);
+			max_abs_lat_ = std::max(max_abs_lat_, std::abs(stop.coords.lat));
+		}
+
+		// square-ish cells holding about STOPS_PER_CELL stops each
+		const double lat_span = std::max(max_lat - min_lat_, MIN_SPAN);
+		const double lng_span = std::max(max_lng - min_lng_, MIN_SPAN);
+		const double cells = std::max(stops.size() / STOPS_PER_CELL, 1.0);
+		rows_ = std::max<size_t>(static_cast<size_t>(std::sqrt(cells * lat_span / lng_span)), 1);
+		cols_ = std::max<size_t>(static_cast<size_t>(cells / rows_), 1);
+		cell_lat_ = lat_span / rows_;
+		cell_lng_ = lng_span / cols_;
+
+		// counting sort of stop IDs by cell
+		std::vector<uint32_t> cell_of_stop(stops.size());
+		cell_offsets_.assign(rows_ * cols_ + 1, 0);
+		for (const Stop& stop : stops) {
+			const uint32_t cell = static_cast<uint32_t>(GetRow(stop.coords.lat) * cols_ + GetCol(stop.coords.lng));
+			cell_of_stop[stop.id] = cell;
+			++cell_offsets_[cell + 1];
+		}
+		for (size_t cell = 0; cell < rows_ * cols_; ++cell) {
+			cell_offsets_[cell + 1] += cell_offsets_[cell];
+		}
+		is_moved_.assign(stops.size(), false);
+		cell_stops_.resize(stops.size());
+		std::vector<uint32_t> fill(cell_offsets_.begin(), cell_offsets_.end() - 1);
+		for (const Stop& stop : stops) {
+			cell_stops_[fill[cell_of_stop[stop.id]]++] = static_cast<uint32_t>(stop.id);
+		}
+	}
+
+	SpatialIndex::SpatialIndex(const SpatialIndex& other, const std::deque<Stop>& stops)
+		: SpatialIndex(other) {
+		if (stops_) {
+			stops_ = &stops;
+		}
+	}
+
+	std::vector<StopDistance> SpatialIndex::FindNearest(geo::Coordinates point, size_t count) const {
+		if (!stops_ || stops_->empty() || count == 0) {
+			return {};
+		}
+
+		auto farther = [](const StopDistance& lhs, const StopDistance& rhs) {
+			return lhs.distance < rhs.distance || (lhs.distance == rhs.distance && lhs.stop->id < rhs.stop->id);
+		};
+		std::priority_queue<StopDistance, std::vector<StopDistance>, decltype(farther)> best(farther);
+
+		auto visit_stop = [&](uint32_t stop_id) {
+			const Stop& stop = (*stops_)[stop_id];
+			StopDistance candidate{ &stop, geo::ComputeDistance(point, stop.coords) };
+			if (best.size() < count) {
+				best.push(candidate);
+			}
+			else if (farther(candidate, best.top())) {
+				best.pop();
+				best.push(candidate);
+			}
+		};
+		auto visit_cell = [&](size_t cell) {
+			for (uint32_t i = cell_offsets_[cell]; i < cell_offsets_[cell + 1]; ++i) {
+				if (!is_moved_[cell_stops_[i]]) {
+					visit_stop(cell_stops_[i]);
+				}
+			}
+		};
+
+		for (uint32_t stop_id : moved_stops_) {
+			visit_stop(stop_id);
+		}
+
+		const size_t row = GetRow(point.lat);
+		const size_t col = GetCol(point.lng);
+
+		// visit rings of cells around the point until no unvisited cell can hold a closer stop
+		for (size_t ring = 0; ; ++ring) {
+			const size_t row_first = row >= ring ? row - ring : 0;
+			const size_t row_last = std::min(row + ring, rows_ - 1);
+			const size_t col_first = col >= ring ? col - ring : 0;
+			const size_t col_last = std::min(col + ring, cols_ - 1);
+
+			for (size_t r = row_first; r <= row_last; ++r) {
+				if (r + ring == row || r == row + ring) {
+					for (size_t c = col_first; c <= col_last; ++c) {
+						visit_cell(r * cols_ + c);
+					}
+					continue;
+				}
+				if (col >= ring) {
+					visit_cell(r * cols_ + col - ring);
+				}
+				if (ring > 0 && col + ring < cols_) {
+					visit_cell(r * cols_ + col + ring);
+				}
+			}
+
+			const bool whole_grid = row_first == 0 && col_first == 0 && row_last == rows_ - 1 && col_last == cols_ - 1;
+			if (whole_grid) {
+				break;
+			}
+			if (best.size() == count && best.top().distance <= GetLowerBound(point, row, col, ring)) {
+				break;
+			}
+		}
+
+		std::vector<StopDistance> result;
+		result.reserve(best.size());
+		while (!best.empty()) {
+			result.push_back(best.top());
+			best.pop();
+		}
+		std::reverse(result.begin(), result.end());
+		return result;
+	}
+
+	std::vector<const Stop*> SpatialIndex::FindInArea(geo::Coordinates min, geo::Coordinates max) const {
+		std::vector<const Stop*> result;
+		if (!stops_ || stops_->empty() || min.lat > max.lat || min.lng > max.lng) {
+			return result;
+		}
+
+		auto add_if_inside = [&](uint32_t stop_id) {
+			const Stop& stop = (*stops_)[stop_id];
+			if (stop.coords.lat >= min.lat && stop.coords.lat <= max.lat
+				&& stop.coords.lng >= min.lng && stop.coords.lng <= max.lng) {
+				result.push_back(&stop);
+			}
+		};
+
+		const size_t row_last = GetRow(max.lat);
+		const size_t col_last = GetCol(max.lng);
+		for (size_t r = GetRow(min.lat); r <= row_last; ++r) {
+			for (size_t c = GetCol(min.lng); c <= col_last; ++c) {
+				const size_t cell = r * cols_ + c;
+				for (uint32_t i = cell_offsets_[cell]; i < cell_offsets_[cell + 1]; ++i) {
+					if (!is_moved_[cell_stops_[i]]) {
+						add_if_inside(cell_stops_[i]);
+					}
+				}
+			}
+		}
+		for (uint32_t stop_id : moved_stops_) {
+			add_if_inside(stop_id);
+		}
+
+		std::sort(result.begin(), result.end(), [](const Stop* lhs, const Stop* rhs) { return *lhs < *rhs; });
+		return result;
+	}
+
+	void SpatialIndex::MoveStop(size_t stop_id) {
+		if (stop_id < is_moved_.size() && !is_moved_[stop_id]) {
+			is_moved_[stop_id] = true;
+			moved_stops_.push_back(static_cast<uint32_t>(stop_id));
+		}
+	}
+
+	size_t SpatialIndex::GetRow(double lat) const {
+		const double row = std::floor((lat - min_lat_) / cell_lat_);
+		return static_cast<size_t>(std::clamp(row, 0.0, static_cast<double>(rows_ - 1)));
+	}
+
+	size_t SpatialIndex::GetCol(double lng) const {
+		const double col = std::floor((lng - min_lng_) / cell_lng_);
+		return static_cast<size_t>(std::clamp(col, 0.0, static_cast<double>(cols_ - 1)));
+	}
+
+	// distance in meters that any stop outside the visited rings is guaranteed to exceed
+	double SpatialIndex::GetLowerBound(geo::Coordinates point, size_t row, size_t col, size_t ring) const {
+		const double infinity = std::numeric_limits<double>::infinity();
+
+		double lat_gap = infinity;
+		if (row >= ring + 1) {
+			lat_gap = std::min(lat_gap, point.lat - (min_lat_ + (row - ring) * cell_lat_));
+		}
+		if (row + ring + 1 < rows_) {
+			lat_gap = std::min(lat_gap, min_lat_ + (row + ring + 1) * cell_lat_ - point.lat);
+		}
+
+		double lng_gap = infinity;
+		if (col >= ring + 1) {
+			lng_gap = std::min(lng_gap, point.lng - (min_lng_ + (col - ring) * cell_lng_));
+		}
+		if (col + ring + 1 < cols_) {
+			lng_gap = std::min(lng_gap, min_lng_ + (col + ring + 1) * cell_lng_ - point.lng);
+		}
+
+		if (lat_gap == infinity && lng_gap == infinity) {
+			return infinity;
+		}
+
+		// great-circle distance is at least the latitude difference, and by the haversine formula
+		// hav(d) >= cos(lat1) * cos(lat2) * hav(dlng) for the longitude difference
+		const double lat_bound = std::max(lat_gap, 0.0) * DEG_TO_RAD * geo::EARTH_RADIUS;
+		const double cos_lat = std::cos(std::max(max_abs_lat_, std::abs(point.lat)) * DEG_TO_RAD);
+		const double half_lng = std::min(std::max(lng_gap, 0.0) * DEG_TO_RAD, M_PI) / 2;
+		const double lng_bound = 2 * std::asin(std::min(cos_lat * std::sin(half_lng), 1.0)) * geo::EARTH_RADIUS;
+		return std::min(lat_bound, lng_bound);
+	}
+}
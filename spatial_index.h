@@ -0,0 +1,53 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <cstdint>
+
+#include "domain.h"
+
+namespace transport_catalogue {
+
+	struct StopDistance {
+		const domain::Stop* stop;
+		double distance;
+	};
+
+	// uniform lat/lng grid over the stops, stop IDs of every cell are stored contiguously (CSR)
+	class SpatialIndex {
+	public:
+		SpatialIndex() = default;
+		explicit SpatialIndex(const std::deque<domain::Stop>& stops);
+		// the same grid over a copy of the stops, moved stops included
+		SpatialIndex(const SpatialIndex& other, const std::deque<domain::Stop>& stops);
+
+		// at most count stops closest to the point, nearest first
+		std::vector<StopDistance> FindNearest(geo::Coordinates point, size_t count) const;
+		// stops inside the box, sorted by name
+		std::vector<const domain::Stop*> FindInArea(geo::Coordinates min, geo::Coordinates max) const;
+
+		// the stop got new coordinates: it leaves its cell and is scanned on every query until a rebuild
+		void MoveStop(size_t stop_id);
+		size_t GetMovedCount() const {
+			return moved_stops_.size();
+		}
+
+	private:
+		const std::deque<domain::Stop>* stops_ = nullptr;
+		double min_lat_ = 0.0;
+		double min_lng_ = 0.0;
+		double cell_lat_ = 1.0;
+		double cell_lng_ = 1.0;
+		size_t rows_ = 0;
+		size_t cols_ = 0;
+		double max_abs_lat_ = 0.0;
+		std::vector<uint32_t> cell_offsets_; // rows_ * cols_ + 1 entries
+		std::vector<uint32_t> cell_stops_;
+		std::vector<bool> is_moved_;
+		std::vector<uint32_t> moved_stops_;
+
+		size_t GetRow(double lat) const;
+		size_t GetCol(double lng) const;
+		double GetLowerBound(geo::Coordinates point, size_t row, size_t col, size_t ring) const;
+	};
+}
@@ -0,0 +1,115 @@
+#include "stop_buses_index.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace transport_catalogue {
+
+	using namespace domain;
+
+	void StopBusesIndex::Build(const std::deque<Bus>& buses, size_t stop_count) {
+		// every (stop, bus) pair once, grouped by stop and ordered by bus name
+		std::vector<std::pair<uint32_t, uint32_t>> stop_buses;
+		for (const Bus& bus : buses) {
+			for (uint32_t stop_id : bus.route) {
+				stop_buses.emplace_back(stop_id, static_cast<uint32_t>(bus.id));
+			}
+		}
+		std::sort(stop_buses.begin(), stop_buses.end(), [&buses](const auto& lhs, const auto& rhs) {
+			return lhs.first < rhs.first || (lhs.first == rhs.first && buses[lhs.second].bus < buses[rhs.second].bus);
+		});
+		stop_buses.erase(std::unique(stop_buses.begin(), stop_buses.end()), stop_buses.end());
+
+		size_.assign(stop_count, 0);
+		for (const auto& [stop_id, bus_id] : stop_buses) {
+			++size_[stop_id];
+		}
+		first_.assign(stop_count, 0);
+		for (size_t stop_id = 1; stop_id < stop_count; ++stop_id) {
+			first_[stop_id] = first_[stop_id - 1] + size_[stop_id - 1];
+		}
+		capacity_ = size_;
+		unused_ = 0;
+
+		bus_ids_.resize(stop_buses.size());
+		std::transform(stop_buses.begin(), stop_buses.end(), bus_ids_.begin(), [](const auto& item) { return item.second; });
+	}
+
+	void StopBusesIndex::AddStop() {
+		first_.push_back(static_cast<uint32_t>(bus_ids_.size()));
+		size_.push_back(0);
+		capacity_.push_back(0);
+	}
+
+	void StopBusesIndex::Insert(size_t stop_id, size_t bus_id, const std::deque<Bus>& buses) {
+		auto slot_begin = bus_ids_.begin() + first_[stop_id];
+		auto slot_end = slot_begin + size_[stop_id];
+		auto position = std::lower_bound(slot_begin, slot_end, buses[bus_id].bus,
+			[&buses](uint32_t id, std::string_view name) { return buses[id].bus < name; });
+		if (position != slot_end && *position == bus_id) {
+			return;
+		}
+		const size_t offset = position - slot_begin;
+
+		if (size_[stop_id] == capacity_[stop_id]) {
+			// move the slot to the end of the array with room to grow; the old place stays unused
+			const uint32_t new_first = static_cast<uint32_t>(bus_ids_.size());
+			const uint32_t new_capacity = std::max<uint32_t>(4, capacity_[stop_id] * 2);
+			bus_ids_.resize(bus_ids_.size() + new_capacity);
+			std::copy_n(bus_ids_.begin() + first_[stop_id], size_[stop_id], bus_ids_.begin() + new_first);
+			first_[stop_id] = new_first;
+			unused_ += capacity_[stop_id];
+			capacity_[stop_id] = new_capacity;
+			if (unused_ * 2 > bus_ids_.size()) {
+				Compact();
+			}
+		}
+
+		slot_begin = bus_ids_.begin() + first_[stop_id];
+		slot_end = slot_begin + size_[stop_id];
+		std::copy_backward(slot_begin + offset, slot_end, slot_end + 1);
+		slot_begin[offset] = static_cast<uint32_t>(bus_id);
+		++size_[stop_id];
+	}
+
+	// every slot again back to back in stop order, each keeping its capacity
+	void StopBusesIndex::Compact() {
+		std::vector<uint32_t> bus_ids;
+		bus_ids.reserve(bus_ids_.size() - unused_);
+		for (size_t stop_id = 0; stop_id < first_.size(); ++stop_id) {
+			const uint32_t new_first = static_cast<uint32_t>(bus_ids.size());
+			bus_ids.insert(bus_ids.end(), bus_ids_.begin() + first_[stop_id], bus_ids_.begin() + first_[stop_id] + capacity_[stop_id]);
+			first_[stop_id] = new_first;
+		}
+		bus_ids_ = std::move(bus_ids);
+		unused_ = 0;
+	}
+
+	void StopBusesIndex::Erase(size_t stop_id, size_t bus_id, const std::deque<Bus>& buses) {
+		auto slot_begin = bus_ids_.begin() + first_[stop_id];
+		auto slot_end = slot_begin + size_[stop_id];
+		auto position = std::lower_bound(slot_begin, slot_end, buses[bus_id].bus,
+			[&buses](uint32_t id, std::string_view name) { return buses[id].bus < name; });
+		if (position == slot_end || *position != bus_id) {
+			return;
+		}
+		std::copy(position + 1, slot_end, position);
+		--size_[stop_id];
+	}
+
+	void StopBusesIndex::Replace(size_t stop_id, size_t old_bus_id, size_t new_bus_id) {
+		auto slot_begin = bus_ids_.begin() + first_[stop_id];
+		auto slot_end = slot_begin + size_[stop_id];
+		std::replace(slot_begin, slot_end, static_cast<uint32_t>(old_bus_id), static_cast<uint32_t>(new_bus_id));
+	}
+
+	StopBusesView StopBusesIndex::GetBuses(size_t stop_id, const std::deque<Bus>& buses) const {
+		const uint32_t* first = bus_ids_.data() + first_[stop_id];
+		return { first, first + size_[stop_id], &buses };
+	}
+
+	std::pair<const uint32_t*, const uint32_t*> StopBusesIndex::GetBusIDs(size_t stop_id) const {
+		const uint32_t* first = bus_ids_.data() + first_[stop_id];
+		return { first, first + size_[stop_id] };
+	}
+}
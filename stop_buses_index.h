@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "domain.h"
+
+namespace transport_catalogue {
+
+	// names of the buses serving one stop, in name order; a view into the index, nothing is copied
+	class StopBusesView {
+	public:
+		class Iterator {
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::string_view;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const std::string_view*;
+			using reference = std::string_view;
+
+			Iterator(const uint32_t* bus_id, const std::deque<domain::Bus>* buses)
+				: bus_id_(bus_id), buses_(buses) {
+			}
+
+			std::string_view operator*() const {
+				return (*buses_)[*bus_id_].bus;
+			}
+			Iterator& operator++() {
+				++bus_id_;
+				return *this;
+			}
+			bool operator==(const Iterator& other) const {
+				return bus_id_ == other.bus_id_;
+			}
+			bool operator!=(const Iterator& other) const {
+				return bus_id_ != other.bus_id_;
+			}
+
+		private:
+			const uint32_t* bus_id_;
+			const std::deque<domain::Bus>* buses_;
+		};
+
+		StopBusesView(const uint32_t* first, const uint32_t* last, const std::deque<domain::Bus>* buses)
+			: first_(first), last_(last), buses_(buses) {
+		}
+
+		Iterator begin() const {
+			return { first_, buses_ };
+		}
+		Iterator end() const {
+			return { last_, buses_ };
+		}
+		size_t size() const {
+			return last_ - first_;
+		}
+		bool empty() const {
+			return first_ == last_;
+		}
+
+	private:
+		const uint32_t* first_;
+		const uint32_t* last_;
+		const std::deque<domain::Bus>* buses_;
+	};
+
+	// stop -> buses index: bus IDs of every stop, sorted by bus name, in one array (CSR).
+	// Each stop owns a slot of the array; a slot that overflows on Insert moves to the end, and once the
+	// slots left behind take half the array it is packed again.
+	class StopBusesIndex {
+	public:
+		void Build(const std::deque<domain::Bus>& buses, size_t stop_count);
+		void AddStop();
+		void Insert(size_t stop_id, size_t bus_id, const std::deque<domain::Bus>& buses);
+		void Erase(size_t stop_id, size_t bus_id, const std::deque<domain::Bus>& buses);
+		void Replace(size_t stop_id, size_t old_bus_id, size_t new_bus_id); // same bus, new ID
+		StopBusesView GetBuses(size_t stop_id, const std::deque<domain::Bus>& buses) const;
+		std::pair<const uint32_t*, const uint32_t*> GetBusIDs(size_t stop_id) const;
+		size_t GetSize() const { // entries of the array, free room and moved-away slots included
+			return bus_ids_.size();
+		}
+
+	private:
+		std::vector<uint32_t> bus_ids_;
+		std::vector<uint32_t> first_;
+		std::vector<uint32_t> size_;
+		std::vector<uint32_t> capacity_;
+		size_t unused_ = 0; // entries of slots that moved away
+
+		void Compact();
+	};
+}
@@ -173,10 +173,22 @@ namespace svg {
     }
 
     void Document::Render(std::ostream& out) const {
+        RenderBegin(out);
+        RenderObjects(out);
+        RenderEnd(out);
+    }
+
+    void Document::RenderBegin(std::ostream& out) {
         out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>"sv << std::endl;
         out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">"sv << std::endl;
+    }
+
+    void Document::RenderObjects(std::ostream& out) const {
         RenderContext ctx(out, 2, 2);
         std::for_each(objects_.begin(), objects_.end(), [&](const auto& obj) { obj->Render(ctx); });
+    }
+
+    void Document::RenderEnd(std::ostream& out) {
         out << "</svg>"sv;
     }
 }  // namespace svg
\ No newline at end of file
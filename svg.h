@@ -233,6 +233,11 @@ namespace svg {
         void AddPtr(std::unique_ptr<Object>&& obj);
         void Render(std::ostream& out) const;
 
+        // the parts of Render, for assembling one document from several rendered pieces
+        static void RenderBegin(std::ostream& out);
+        void RenderObjects(std::ostream& out) const;
+        static void RenderEnd(std::ostream& out);
+
     private:
         std::vector<std::unique_ptr<Object>> objects_;
     };
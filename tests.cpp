@@ -0,0 +1,723 @@
+#include "tests.h"
+#include "geo.h"
+#include "json.h"
+#include "json_builder.h"
+#include "transport_catalogue.h"
+#include "request_handler.h"
+#include "route_weight.h"
+#include "router.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace transport_catalogue {
+
+	namespace tests {
+
+		using namespace std::literals;
+
+		namespace {
+
+			void Check(bool condition, const std::string& what) {
+				if (!condition) {
+					throw std::logic_error(what);
+				}
+			}
+
+			// what a catalogue is loaded from, kept to apply the same edits to and load again
+			struct Network {
+				struct Route {
+					std::string bus;
+					std::vector<uint32_t> stops;
+					bool is_circle;
+				};
+
+				std::vector<std::pair<std::string, geo::Coordinates>> stops;
+				std::vector<Route> buses;
+				std::map<std::pair<uint32_t, uint32_t>, size_t> distances;
+			};
+
+			class NetworkGenerator {
+			public:
+				explicit NetworkGenerator(uint32_t seed)
+					: generator_(seed) {
+				}
+
+				geo::Coordinates GetPoint() {
+					return { lat_(generator_), lng_(generator_) };
+				}
+
+				size_t GetIndex(size_t count) {
+					return std::uniform_int_distribution<size_t>(0, count - 1)(generator_);
+				}
+
+				size_t GetDistance() {
+					return std::uniform_int_distribution<size_t>(300, 3000)(generator_);
+				}
+
+				// 2 to 8 stops, every third route a circle; the road distances of its legs are set in the network
+				Network::Route GetRoute(Network& network, std::string bus, bool is_circle) {
+					std::vector<uint32_t> route(2 + GetIndex(7));
+					for (uint32_t& stop_id : route) {
+						stop_id = static_cast<uint32_t>(GetIndex(network.stops.size()));
+					}
+					if (is_circle) {
+						route.push_back(route.front());
+					}
+					for (size_t j = 0; j + 1 < route.size(); ++j) {
+						const size_t forward = GetDistance();
+						network.distances[{ route[j], route[j + 1] }] = forward;
+						// a third of the legs differ by direction
+						network.distances[{ route[j + 1], route[j] }] = j % 3 == 0 ? GetDistance() : forward;
+					}
+					return { std::move(bus), std::move(route), is_circle };
+				}
+
+				// stops "Stop 0".. around Sochi and buses "Bus 0".. over random stops
+				Network GetNetwork(size_t stop_count, size_t bus_count) {
+					Network network;
+					for (size_t i = 0; i < stop_count; ++i) {
+						network.stops.emplace_back("Stop "s + std::to_string(i), GetPoint());
+					}
+					for (size_t i = 0; i < bus_count; ++i) {
+						network.buses.push_back(GetRoute(network, "Bus "s + std::to_string(i), i % 3 == 0));
+					}
+					return network;
+				}
+
+			private:
+				std::mt19937 generator_;
+				std::uniform_real_distribution<double> lat_{ 43.5, 43.7 };
+				std::uniform_real_distribution<double> lng_{ 39.6, 39.8 };
+			};
+
+			void LoadNetwork(TransportCatalogue& catalogue, const Network& network) {
+				TransportCatalogue::BulkLoader loader(catalogue);
+				for (const auto& [name, coords] : network.stops) {
+					loader.AddStop(Stop{ name, coords });
+				}
+				for (const Network::Route& route : network.buses) {
+					loader.AddBus(route.bus, route.stops, route.is_circle);
+				}
+				for (const auto& [stops, distance] : network.distances) {
+					loader.AddDistance(stops.first, stops.second, distance);
+				}
+				loader.Finalize();
+			}
+
+			void LoadNetwork(TransportCatalogue& catalogue, uint32_t seed, size_t stop_count, size_t bus_count) {
+				LoadNetwork(catalogue, NetworkGenerator(seed).GetNetwork(stop_count, bus_count));
+			}
+
+			// edge weights lie on the 2^-32 minute grid in either build, so any order of sums gives the same weight
+			bool IsSameWeight(double weight, double expected) {
+				return weight == expected;
+			}
+
+			// an updated route table against one built from scratch: the same weight for every pair, and a route
+			// of contiguous edges adding up to it
+			void CheckSameRoutes(const graph::DirectedWeightedGraph<RouteWeight>& graph, const graph::Router<RouteWeight>& updated,
+				const std::string& when) {
+				const graph::Router<RouteWeight> rebuilt(graph);
+				for (graph::VertexId from = 0; from < graph.GetVertexCount(); ++from) {
+					for (graph::VertexId to = 0; to < graph.GetVertexCount(); ++to) {
+						const auto route = updated.BuildRoute(from, to);
+						const auto expected = rebuilt.BuildRoute(from, to);
+						const std::string pair = when + ": "s + std::to_string(from) + " - "s + std::to_string(to);
+						Check(route.has_value() == expected.has_value() && (!route || IsSameWeight(route->weight, expected->weight)),
+							pair + " differs from the rebuilt table"s);
+						if (!route) {
+							continue;
+						}
+						graph::VertexId at = from;
+						RouteWeight sum{};
+						for (graph::EdgeId edge_id : route->edges) {
+							const auto& edge = graph.GetEdge(edge_id);
+							Check(edge.from == at, pair + " is not a chain of edges"s);
+							at = edge.to;
+							sum += edge.weight;
+						}
+						Check(at == to && IsSameWeight(sum, route->weight), pair + " does not add up"s);
+					}
+				}
+			}
+
+			// a patched router against one built from scratch over the same catalogue: the same route time for every pair of stops
+			void CheckSameShortestRoutes(const TransportCatalogue& catalogue, const TransportRouter& updated, const TransportRouter& rebuilt,
+				const std::string& when) {
+				for (const Stop& from : catalogue.GetAllStops()) {
+					for (const Stop& to : catalogue.GetAllStops()) {
+						const auto route = updated.GetShortestRoute(from.stop, to.stop);
+						const auto expected = rebuilt.GetShortestRoute(from.stop, to.stop);
+						Check(route.has_value() == expected.has_value() && (!route || IsSameWeight(route->weight, expected->weight)),
+							when + ": "s + std::string(from.stop) + " - "s + std::string(to.stop) + " differs from the rebuilt router "s
+							+ (route ? std::to_string(route->weight) : "none"s) + " vs "s + (expected ? std::to_string(expected->weight) : "none"s));
+					}
+				}
+			}
+
+			std::vector<std::string_view> GetBusNames(const TransportCatalogue& catalogue, std::string_view stop) {
+				const auto buses = catalogue.GetBusesByStop(stop);
+				return { buses->begin(), buses->end() };
+			}
+
+			// every Bus and Stop answer, the nearest stops and the stops in an area of an edited catalogue against
+			// the same network loaded from scratch
+			void CheckSameAsRebuilt(const TransportCatalogue& edited, const Network& network,
+				const std::vector<std::string>& removed, NetworkGenerator& generator, const std::string& when) {
+				TransportCatalogue rebuilt;
+				LoadNetwork(rebuilt, network);
+
+				Check(edited.GetAllBuses().size() == network.buses.size(), when + ": "s
+					+ std::to_string(edited.GetAllBuses().size()) + " buses instead of "s + std::to_string(network.buses.size()));
+				for (const Network::Route& route : network.buses) {
+					const auto info = edited.GetInfoAboutBus(route.bus);
+					const auto expected = rebuilt.GetInfoAboutBus(route.bus);
+					Check(info && info->stops == expected->stops && info->unique_stops == expected->unique_stops
+						&& info->route_length == expected->route_length && info->curve == expected->curve,
+						when + ": "s + route.bus + " differs"s);
+				}
+				for (const std::string& bus : removed) {
+					Check(!edited.GetInfoAboutBus(bus), when + ": removed "s + bus + " is still found"s);
+				}
+				for (const auto& [stop, coords] : network.stops) {
+					Check(GetBusNames(edited, stop) == GetBusNames(rebuilt, stop), when + ": the buses of "s + stop + " differ"s);
+				}
+
+				for (size_t i = 0; i < 20; ++i) {
+					const geo::Coordinates point = generator.GetPoint();
+					const auto nearest = edited.GetNearestStops(point, 5);
+					const auto expected = rebuilt.GetNearestStops(point, 5);
+					bool is_same = nearest.size() == expected.size();
+					for (size_t j = 0; is_same && j < nearest.size(); ++j) {
+						is_same = nearest[j].stop->id == expected[j].stop->id && nearest[j].distance == expected[j].distance;
+					}
+					Check(is_same, when + ": the nearest stops differ"s);
+
+					const geo::Coordinates corner = generator.GetPoint();
+					auto ids = [&](const TransportCatalogue& catalogue) {
+						std::vector<size_t> result;
+						for (const Stop* stop : catalogue.GetStopsInArea({ std::min(point.lat, corner.lat), std::min(point.lng, corner.lng) },
+							{ std::max(point.lat, corner.lat), std::max(point.lng, corner.lng) })) {
+							result.push_back(stop->id);
+						}
+						std::sort(result.begin(), result.end());
+						return result;
+					};
+					Check(ids(edited) == ids(rebuilt), when + ": the stops in an area differ"s);
+				}
+			}
+			// the printed answer of a Route request between the vertices of each query, with the graph's ride edges
+			// rounded to Weight the way TransportGraph rounds them to RouteWeight
+			template <typename Weight>
+			std::vector<std::string> PrintRoutes(const TransportGraph& transport_graph, const std::vector<std::pair<graph::VertexId, graph::VertexId>>& queries) {
+				const auto& inner_graph = transport_graph.GetInnerGraph();
+				graph::DirectedWeightedGraph<Weight> graph(inner_graph.GetVertexCount());
+				for (graph::EdgeId edge_id = 0; edge_id < inner_graph.GetEdgeCount(); ++edge_id) {
+					const auto& edge = inner_graph.GetEdge(edge_id);
+					const double ride_time = transport_graph.GetSegmentByID(edge_id).time;
+					graph.AddEdge({ edge.from, edge.to, ToWeight<Weight>(transport_graph.GetSettings().wait_time + ride_time) });
+				}
+				const graph::Router<Weight> router(graph);
+
+				std::vector<std::string> answers;
+				for (const auto& [from, to] : queries) {
+					const auto route = router.BuildRoute(from, to);
+					if (!route) {
+						answers.push_back("not found"s);
+						continue;
+					}
+					json::Array items;
+					for (graph::EdgeId edge_id : route->edges) {
+						items.push_back(json::Builder{}.StartDict().
+							Key("time"s).Value(transport_graph.GetWaitSegment(graph.GetEdge(edge_id).from).time).EndDict().Build());
+						items.push_back(json::Builder{}.StartDict().
+							Key("time"s).Value(transport_graph.GetSegmentByID(edge_id).time).EndDict().Build());
+					}
+					std::ostringstream out;
+					json::Print(json::Document(json::Builder{}.StartDict().
+						Key("items"s).Value(std::move(items)).
+						Key("total_time"s).Value(ToMinutes(route->weight)).
+						EndDict().Build()), out);
+					answers.push_back(out.str());
+				}
+				return answers;
+			}
+		}
+
+		// the batch kernel against ComputeDistance on the original coordinates: equal to the bit, including
+		// pairs of one point and pairs of points at the same place
+		void BatchDistancesMatchScalar() {
+			constexpr size_t POINT_COUNT = 2000;
+			constexpr size_t PAIR_COUNT = 20000;
+			std::mt19937 generator(29);
+			std::uniform_real_distribution<double> lat(43.5, 43.7);
+			std::uniform_real_distribution<double> lng(39.6, 39.8);
+
+			std::vector<geo::Coordinates> points;
+			geo::CoordinatesTable table;
+			for (size_t i = 0; i < POINT_COUNT; ++i) {
+				// every tenth point repeats an earlier one
+				points.push_back(i % 10 == 9 ? points[i / 2] : geo::Coordinates{ lat(generator), lng(generator) });
+				table.Add(points.back());
+			}
+			points.push_back({ -89.9, -179.9 }); // far away and across the date line
+			table.Add(points.back());
+			points.push_back({ 89.9, 179.9 });
+			table.Add(points.back());
+
+			std::uniform_int_distribution<uint32_t> point(0, static_cast<uint32_t>(points.size() - 1));
+			std::vector<uint32_t> from(PAIR_COUNT);
+			std::vector<uint32_t> to(PAIR_COUNT);
+			for (size_t i = 0; i < PAIR_COUNT; ++i) {
+				from[i] = point(generator);
+				to[i] = i % 7 == 0 ? from[i] : point(generator);
+			}
+			std::vector<double> distances(PAIR_COUNT);
+			geo::ComputeDistances(table, from.data(), to.data(), PAIR_COUNT, distances.data());
+
+			for (size_t i = 0; i < PAIR_COUNT; ++i) {
+				const double expected = geo::ComputeDistance(points[from[i]], points[to[i]]);
+				const bool is_same = expected == distances[i] || (std::isnan(expected) && std::isnan(distances[i]));
+				Check(is_same, "pair "s + std::to_string(from[i]) + " - "s + std::to_string(to[i]) + ": "s
+					+ std::to_string(distances[i]) + " instead of "s + std::to_string(expected));
+			}
+		}
+
+		// an empty name first, names filling a block exactly, and one larger than a block
+		void NamePoolKeepsNames() {
+			NamePool pool;
+			std::vector<std::pair<std::string_view, std::string>> stored;
+			auto store = [&](std::string name) {
+				stored.emplace_back(pool.Store(name), std::move(name));
+			};
+			store(""s);
+			store("Stop 1"s);
+			store(std::string(64 * 1024 - 6, 'a'));
+			store(""s);
+			store("Stop 2"s);
+			store(std::string(100 * 1024, 'b'));
+			store("Stop 3"s);
+			for (const auto& [view, name] : stored) {
+				Check(view == name, "a stored name of "s + std::to_string(name.size()) + " characters changed"s);
+			}
+		}
+
+		// a reader pinned across a publish keeps answering from its version, from another thread's update
+		void SnapshotReaderKeepsVersion() {
+			using Query = interfaces::RequestHandler::Query;
+			TransportCatalogue catalogue;
+			LoadNetwork(catalogue, 34, 60, 12);
+			interfaces::RequestHandler handler(catalogue);
+			handler.SetRouterSettings(TransportGraph::Settings{ 6, 40.0 });
+			const Query bus{ 1, Query::Type::BUS, { "Bus 1"s } };
+			const Query route{ 2, Query::Type::ROUTE, { "Stop 0"s, "Stop 1"s } };
+
+			const auto old_snapshot = handler.Pin();
+			const auto old_bus = handler.InfoBusRequest(*old_snapshot, bus);
+			const auto old_route = handler.GetShortestRouteRequest(*old_snapshot, route);
+			Check(old_snapshot->version == 0 && old_bus.has_value(), "the loaded network is not version 0 with Bus 1"s);
+
+			std::thread writer([&handler] {
+				handler.UpdateNetwork([](NetworkEdit& next) {
+					next.RemoveBus("Bus 1"sv);
+				});
+			});
+			writer.join();
+
+			const auto kept_bus = handler.InfoBusRequest(*old_snapshot, bus);
+			const auto kept_route = handler.GetShortestRouteRequest(*old_snapshot, route);
+			Check(old_snapshot->version == 0, "the pinned snapshot changed its version"s);
+			Check(kept_bus && kept_bus->route_length == old_bus->route_length && kept_bus->stops == old_bus->stops,
+				"the pinned snapshot lost Bus 1"s);
+			Check(kept_route.has_value() == old_route.has_value() && (!kept_route || kept_route->weight == old_route->weight),
+				"the pinned snapshot changed its route"s);
+		}
+
+		// the next pin after an update sees the change, and the untouched buses as they were; its map, drawn on
+		// request, shows the changed network
+		void SnapshotPublishedVersionIsSeen() {
+			using Query = interfaces::RequestHandler::Query;
+			TransportCatalogue catalogue;
+			LoadNetwork(catalogue, 34, 60, 12);
+			interfaces::RequestHandler handler(catalogue);
+			handler.SetRouterSettings(TransportGraph::Settings{ 6, 40.0 });
+			const interfaces::MapRenderer::Settings render_settings{ 600.0, 400.0, 30.0, 4.0, 3.0, 12, { 5.0, -5.0 }, 10,
+				{ 5.0, 5.0 }, "white"s, 2.0, { "green"s, "red"s } };
+			handler.SetRendererSettings(render_settings);
+			const Query bus{ 1, Query::Type::BUS, { "Bus 1"s } };
+			const Query other_bus{ 2, Query::Type::BUS, { "Bus 2"s } };
+			const auto other_info = handler.InfoBusRequest(*handler.Pin(), other_bus);
+
+			handler.UpdateNetwork([](NetworkEdit& next) {
+				next.RemoveBus("Bus 1"sv);
+			});
+			const auto snapshot = handler.Pin();
+			Check(snapshot->version == 1, "the update was published as version "s + std::to_string(snapshot->version));
+			Check(snapshot->router != nullptr, "the update has no router"s);
+			Check(!handler.InfoBusRequest(*snapshot, bus), "Bus 1 is still there after its removal"s);
+			const auto copied_info = handler.InfoBusRequest(*snapshot, other_bus);
+			Check(copied_info && copied_info->route_length == other_info->route_length, "the copy changed Bus 2"s);
+
+			interfaces::MapRenderer renderer;
+			renderer.SetSettings(render_settings);
+			const auto& buses = snapshot->catalogue->GetAllBuses();
+			std::ostringstream expected;
+			renderer.DrawMap(expected, { buses.begin(), buses.end() }, snapshot->catalogue->GetAllStops());
+			for (int i = 0; i < 2; ++i) {
+				std::ostringstream map;
+				handler.DrawMapRequest(*snapshot, map);
+				Check(map.str() == expected.str(), "the map of the update is not the map of its network"s);
+			}
+		}
+
+		// a copy of a catalogue answers as the network loaded from scratch; published edits patch a copy of the router,
+		// so each version routes as a router built over its catalogue, for every engine keeping precomputed data,
+		// while the loaded version keeps its routes
+		void SnapshotEditsMatchRebuild() {
+			NetworkGenerator generator(37);
+			const Network network = generator.GetNetwork(40, 14);
+			TransportCatalogue catalogue;
+			LoadNetwork(catalogue, network);
+			const TransportCatalogue copy(catalogue);
+			CheckSameAsRebuilt(copy, network, {}, generator, "a copy"s);
+
+			for (RouteEngine engine : { RouteEngine::TRANSFER_TABLE, RouteEngine::ALT, RouteEngine::HUB_LABELS }) {
+				TransportGraph::Settings settings{ 6, 40.0 };
+				settings.engine = engine;
+				const std::string when = "engine "s + std::to_string(static_cast<int>(engine));
+				interfaces::RequestHandler handler(catalogue);
+				handler.SetRouterSettings(settings);
+				const std::shared_ptr<const TransportRouter> loaded = handler.Pin()->router;
+
+				for (size_t step = 0; step < 8; ++step) {
+					handler.UpdateNetwork([&](NetworkEdit& edit) {
+						const TransportCatalogue& next = edit.GetCatalogue();
+						const Bus& bus = next.GetAllBuses()[generator.GetIndex(next.GetAllBuses().size())];
+						const std::string name(bus.bus);
+						const size_t leg = generator.GetIndex(bus.route.size() - 1);
+						const std::string from(next.GetStopByID(bus.route[leg]).stop);
+						const std::string to(next.GetStopByID(bus.route[leg + 1]).stop);
+						if (step % 4 == 0) {
+							edit.UpdateDistance(from, to, std::max<size_t>(next.GetDistance(from, to) / 2, 1));
+						}
+						else if (step % 4 == 1) {
+							edit.UpdateBusRoute(name, { bus.route.rbegin(), bus.route.rend() }, bus.is_circle);
+						}
+						else if (step % 4 == 2) {
+							const uint32_t from_id = bus.route[leg];
+							const uint32_t to_id = bus.route[leg + 1];
+							edit.AddBus("Express "s + std::to_string(step), { from_id, to_id }, false);
+						}
+						else {
+							edit.MoveStop(from, generator.GetPoint());
+							edit.RemoveBus(name);
+						}
+					});
+					const auto snapshot = handler.Pin();
+					CheckSameShortestRoutes(*snapshot->catalogue, *snapshot->router, TransportRouter(*snapshot->catalogue, settings),
+						when + ", version "s + std::to_string(snapshot->version));
+				}
+				CheckSameShortestRoutes(catalogue, *loaded, TransportRouter(catalogue, settings), when + ", version 0"s);
+			}
+		}
+
+		// removed, added and rerouted buses, moved stops and changed distances, applied in place, answer as the
+		// network loaded from scratch; checked every 40 edits
+		void LiveEditsMatchRebuild() {
+			NetworkGenerator generator(35);
+			Network network = generator.GetNetwork(80, 24);
+			TransportCatalogue edited;
+			LoadNetwork(edited, network);
+			std::vector<std::string> removed;
+			size_t next_bus = network.buses.size();
+
+			// both directions of every leg, as the network holds them
+			auto set_distances = [&](const std::vector<uint32_t>& route) {
+				for (size_t j = 0; j + 1 < route.size(); ++j) {
+					for (const auto& [from, to] : { std::pair{ route[j], route[j + 1] }, std::pair{ route[j + 1], route[j] } }) {
+						edited.UpdateDistance(network.stops[from].first, network.stops[to].first, network.distances.at({ from, to }));
+					}
+				}
+			};
+
+			// the most buses each stop has had: the room its slot of the stop->buses index may keep
+			std::vector<size_t> peak_buses(network.stops.size(), 0);
+
+			for (size_t edit = 0; edit < 400; ++edit) {
+				if (edit % 5 == 0 && network.buses.size() > 1) {
+					const size_t i = generator.GetIndex(network.buses.size());
+					edited.RemoveBus(network.buses[i].bus);
+					removed.push_back(network.buses[i].bus);
+					network.buses.erase(network.buses.begin() + i);
+				}
+				else if (edit % 5 == 1) {
+					Network::Route route = generator.GetRoute(network, "Bus "s + std::to_string(next_bus++), edit % 3 == 0);
+					// half the buses come before the distances of their new legs, their stats follow the distances
+					if (edit % 2 == 0) {
+						set_distances(route.stops);
+						edited.AddBus(route.bus, route.stops, route.is_circle);
+					}
+					else {
+						edited.AddBus(route.bus, route.stops, route.is_circle);
+						set_distances(route.stops);
+					}
+					network.buses.push_back(std::move(route));
+				}
+				else if (edit % 5 == 2) {
+					Network::Route& route = network.buses[generator.GetIndex(network.buses.size())];
+					route = generator.GetRoute(network, route.bus, edit % 2 == 0);
+					set_distances(route.stops);
+					edited.UpdateBusRoute(route.bus, route.stops, route.is_circle);
+				}
+				else if (edit % 5 == 3) {
+					auto& [stop, coords] = network.stops[generator.GetIndex(network.stops.size())];
+					coords = generator.GetPoint();
+					edited.MoveStop(stop, coords);
+				}
+				else {
+					auto it = std::next(network.distances.begin(), generator.GetIndex(network.distances.size()));
+					it->second = generator.GetDistance();
+					edited.UpdateDistance(network.stops[it->first.first].first, network.stops[it->first.second].first, it->second);
+				}
+
+				// the gaps edits leave are packed away before they take half of either array
+				size_t route_stops = 0;
+				for (const Network::Route& route : network.buses) {
+					route_stops += route.stops.size();
+				}
+				size_t index_room = 0;
+				for (size_t stop_id = 0; stop_id < network.stops.size(); ++stop_id) {
+					peak_buses[stop_id] = std::max(peak_buses[stop_id], GetBusNames(edited, network.stops[stop_id].first).size());
+					index_room += std::max<size_t>(4, 2 * peak_buses[stop_id]);
+				}
+				Check(edited.GetRoutePoolSize() <= 2 * route_stops, "after edit "s + std::to_string(edit) + ": the route pool holds "s
+					+ std::to_string(edited.GetRoutePoolSize()) + " stops for "s + std::to_string(route_stops));
+				Check(edited.GetStopBusesIndexSize() <= 2 * index_room, "after edit "s + std::to_string(edit) + ": the stop->buses index holds "s
+					+ std::to_string(edited.GetStopBusesIndexSize()) + " entries for room of "s + std::to_string(index_room));
+
+				if (edit % 40 == 39) {
+					CheckSameAsRebuilt(edited, network, removed, generator, "after edit "s + std::to_string(edit));
+				}
+			}
+		}
+
+		// edges added to the graph, some joining blocks, and edges made lighter, each merged into the table by
+		// UpdateWithEdges, against Router(graph) built from scratch
+		void RouterUpdatesMatchRebuild() {
+			constexpr size_t VERTEX_COUNT = 50;
+			constexpr size_t GROUP_SIZE = 10;
+			std::mt19937 generator(36);
+			std::uniform_int_distribution<graph::VertexId> vertex(0, VERTEX_COUNT - 1);
+			std::uniform_int_distribution<graph::VertexId> in_group(0, GROUP_SIZE - 1);
+			std::uniform_real_distribution<double> minutes(1.0, 30.0);
+
+			// edges within groups of ten vertices first, so the graph starts in several blocks
+			graph::DirectedWeightedGraph<RouteWeight> graph(VERTEX_COUNT);
+			for (size_t i = 0; i < 120; ++i) {
+				const graph::VertexId from = vertex(generator);
+				graph.AddEdge({ from, from / GROUP_SIZE * GROUP_SIZE + in_group(generator), ToRouteWeight(minutes(generator)) });
+			}
+			graph::Router<RouteWeight> router(graph);
+			CheckSameRoutes(graph, router, "before any update"s);
+
+			for (size_t step = 0; step < 60; ++step) {
+				if (step % 3 == 0) {
+					const graph::EdgeId edge_id = std::uniform_int_distribution<graph::EdgeId>(0, graph.GetEdgeCount() - 1)(generator);
+					graph.SetEdgeWeight(edge_id, ToRouteWeight(ToMinutes(graph.GetEdge(edge_id).weight) / 2));
+					router.UpdateWithEdges(edge_id, edge_id + 1);
+				}
+				else {
+					const graph::EdgeId first = static_cast<graph::EdgeId>(graph.GetEdgeCount());
+					for (size_t i = 0; i <= step % 3; ++i) {
+						const graph::VertexId from = vertex(generator);
+						const graph::VertexId to = step % 5 == 0 ? vertex(generator) : from / GROUP_SIZE * GROUP_SIZE + in_group(generator);
+						graph.AddEdge({ from, to, ToRouteWeight(minutes(generator)) });
+					}
+					router.UpdateWithEdges(first, static_cast<graph::EdgeId>(graph.GetEdgeCount()));
+				}
+				CheckSameRoutes(graph, router, "after update "s + std::to_string(step));
+			}
+		}
+
+		// buses added between transfer stops and faster rides, merged into the route table, then removed and
+		// rerouted buses, against a TransportRouter built from scratch over the same catalogue
+		void TransportRouterUpdatesMatchRebuild() {
+			NetworkGenerator generator(36);
+			const Network network = generator.GetNetwork(60, 20);
+			TransportCatalogue catalogue;
+			LoadNetwork(catalogue, network);
+			const TransportGraph::Settings settings{ 6, 40.0 };
+			TransportRouter router(catalogue, settings);
+
+			auto get_bus = [&]() -> const Bus& {
+				return catalogue.GetAllBuses()[generator.GetIndex(catalogue.GetAllBuses().size())];
+			};
+			for (size_t step = 0; step < 16; ++step) {
+				if (step % 4 == 0) {
+					std::vector<const Stop*> transfers;
+					for (const Stop& stop : catalogue.GetAllStops()) {
+						const auto buses = catalogue.GetBusesByStop(stop.stop);
+						if (std::distance(buses->begin(), buses->end()) > 1) {
+							transfers.push_back(&stop);
+						}
+					}
+					const Stop* from = transfers[generator.GetIndex(transfers.size())];
+					const Stop* to = transfers[generator.GetIndex(transfers.size())];
+					// a distance some bus already rides stays, changing it is UpdateDistance's job
+					const auto& distances = catalogue.GetAllDistances();
+					if (!distances.count({ from, to }) && !distances.count({ to, from })) {
+						catalogue.SetDistance(from->stop, to->stop, generator.GetDistance());
+					}
+					const std::string bus = "Express "s + std::to_string(step);
+					catalogue.AddBus(bus, { static_cast<uint32_t>(from->id), static_cast<uint32_t>(to->id) }, false);
+					router.AddBus(catalogue, bus);
+				}
+				else if (step % 4 == 1 || step % 4 == 2) {
+					const Bus& bus = get_bus();
+					const size_t leg = generator.GetIndex(bus.route.size() - 1);
+					const std::string from(catalogue.GetStopByID(bus.route[leg]).stop);
+					const std::string to(catalogue.GetStopByID(bus.route[leg + 1]).stop);
+					catalogue.UpdateDistance(from, to, std::max<size_t>(catalogue.GetDistance(from, to) / 2, 1));
+					router.UpdateDistance(catalogue, from, to);
+				}
+				else if (step % 8 == 3) {
+					const std::string bus(get_bus().bus);
+					catalogue.RemoveBus(bus);
+					router.RemoveBus(catalogue, bus);
+				}
+				else {
+					const Bus& bus = get_bus();
+					const std::vector<uint32_t> reversed(bus.route.rbegin(), bus.route.rend());
+					const std::string name(bus.bus);
+					catalogue.UpdateBusRoute(name, reversed, bus.is_circle);
+					router.UpdateBusRoute(catalogue, name);
+				}
+
+				CheckSameShortestRoutes(catalogue, router, TransportRouter(catalogue, settings), "after update "s + std::to_string(step));
+			}
+		}
+
+		// a reweighted router answers as one built with the new settings, for every engine and for a switch of
+		// engine; set through the handler, the reweighted copy is published and the pinned version keeps its times
+		void RouterSettingsMatchRebuild() {
+			TransportCatalogue catalogue;
+			LoadNetwork(catalogue, 38, 50, 18);
+			const TransportGraph::Settings loaded{ 6, 40.0 };
+
+			for (RouteEngine engine : { RouteEngine::TRANSFER_TABLE, RouteEngine::ALT, RouteEngine::HUB_LABELS, RouteEngine::RAPTOR }) {
+				const std::string when = "engine "s + std::to_string(static_cast<int>(engine));
+				TransportGraph::Settings slower{ 2, 25.0 };
+				slower.engine = engine;
+				TransportGraph::Settings first = loaded;
+				first.engine = engine;
+				TransportRouter router(catalogue, first);
+				router.SetSettings(slower);
+				CheckSameShortestRoutes(catalogue, router, TransportRouter(catalogue, slower), when + ", reweighted"s);
+				router.SetSettings(loaded);
+				CheckSameShortestRoutes(catalogue, router, TransportRouter(catalogue, loaded), when + ", back to the table"s);
+			}
+
+			interfaces::RequestHandler handler(catalogue);
+			handler.SetRouterSettings(loaded);
+			const std::shared_ptr<const TransportRouter> pinned = handler.Pin()->router;
+			const TransportGraph::Settings slower{ 2, 25.0 };
+			handler.SetRouterSettings(slower);
+			const auto snapshot = handler.Pin();
+			Check(snapshot->version == 1 && snapshot->router != pinned, "the new settings were not published as a new version"s);
+			CheckSameShortestRoutes(catalogue, *snapshot->router, TransportRouter(catalogue, slower), "published"s);
+			CheckSameShortestRoutes(catalogue, *pinned, TransportRouter(catalogue, loaded), "pinned"s);
+		}
+
+		// every engine gives a route the total time of its route matrix cell: both convert the same weight
+		void RouteMatrixMatchesRoutes() {
+			TransportCatalogue catalogue;
+			LoadNetwork(catalogue, 40, 60, 20);
+			std::vector<std::string_view> stops;
+			for (const Stop& stop : catalogue.GetAllStops()) {
+				stops.push_back(stop.stop);
+			}
+
+			for (RouteEngine engine : { RouteEngine::TRANSFER_TABLE, RouteEngine::ALT, RouteEngine::HUB_LABELS, RouteEngine::RAPTOR }) {
+				TransportGraph::Settings settings{ 6, 40.0 };
+				settings.engine = engine;
+				const TransportRouter router(catalogue, settings);
+				const auto matrix = router.GetRouteMatrix(stops, stops);
+				for (size_t from = 0; from < stops.size(); ++from) {
+					for (size_t to = 0; to < stops.size(); ++to) {
+						const auto route = router.GetShortestRoute(stops[from], stops[to]);
+						const auto& cell = matrix[from][to];
+						Check(route.has_value() == cell.has_value() && (!route || IsSameWeight(route->weight, *cell)),
+							"engine "s + std::to_string(static_cast<int>(engine)) + ", "s + std::string(stops[from]) + " - "s
+							+ std::string(stops[to]) + ": the route and the matrix disagree"s);
+					}
+				}
+			}
+		}
+
+		// Route answers printed from a route table over double minutes and from one over int64 units, as the two
+		// builds have them: the same text, times included
+		void WeightTypesPrintSameRoutes() {
+			TransportCatalogue catalogue;
+			LoadNetwork(catalogue, 50, 150, 40);
+			const TransportRouter router(catalogue, TransportGraph::Settings{ 6, 40.0 });
+			const TransportGraph& transport_graph = router.GetTransportGraph();
+
+			std::vector<std::pair<graph::VertexId, graph::VertexId>> queries;
+			std::mt19937 generator(50);
+			std::uniform_int_distribution<graph::VertexId> vertex(0, transport_graph.GetInnerGraph().GetVertexCount() - 1);
+			for (size_t i = 0; i < 3000; ++i) {
+				queries.emplace_back(vertex(generator), vertex(generator));
+			}
+
+			const std::vector<std::string> in_minutes = PrintRoutes<double>(transport_graph, queries);
+			const std::vector<std::string> in_units = PrintRoutes<int64_t>(transport_graph, queries);
+			for (size_t i = 0; i < queries.size(); ++i) {
+				Check(in_minutes[i] == in_units[i], std::to_string(queries[i].first) + " - "s + std::to_string(queries[i].second)
+					+ " is printed differently:\n"s + in_minutes[i] + "\nagainst\n"s + in_units[i]);
+			}
+		}
+
+		bool RunAll(std::ostream& out) {
+			const std::pair<std::string_view, void (*)()> checks[] = {
+				{ "BatchDistancesMatchScalar"sv, BatchDistancesMatchScalar },
+				{ "NamePoolKeepsNames"sv, NamePoolKeepsNames },
+				{ "SnapshotReaderKeepsVersion"sv, SnapshotReaderKeepsVersion },
+				{ "SnapshotPublishedVersionIsSeen"sv, SnapshotPublishedVersionIsSeen },
+				{ "SnapshotEditsMatchRebuild"sv, SnapshotEditsMatchRebuild },
+				{ "LiveEditsMatchRebuild"sv, LiveEditsMatchRebuild },
+				{ "RouterUpdatesMatchRebuild"sv, RouterUpdatesMatchRebuild },
+				{ "TransportRouterUpdatesMatchRebuild"sv, TransportRouterUpdatesMatchRebuild },
+				{ "RouterSettingsMatchRebuild"sv, RouterSettingsMatchRebuild },
+				{ "RouteMatrixMatchesRoutes"sv, RouteMatrixMatchesRoutes },
+				{ "WeightTypesPrintSameRoutes"sv, WeightTypesPrintSameRoutes },
+			};
+			bool is_ok = true;
+			for (const auto& [name, check] : checks) {
+				try {
+					check();
+					out << name << ": OK\n"sv;
+				}
+				catch (const std::exception& error) {
+					out << name << ": FAILED, "sv << error.what() << '\n';
+					is_ok = false;
+				}
+			}
+			return is_ok;
+		}
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <iostream>
+
+namespace transport_catalogue {
+
+	// self-checks over generated networks, run by `transport_catalogue test`; each one throws
+	// std::logic_error describing the first mismatch it finds
+	namespace tests {
+
+		void BatchDistancesMatchScalar();
+		void NamePoolKeepsNames();
+		void SnapshotReaderKeepsVersion();
+		void SnapshotPublishedVersionIsSeen();
+		void SnapshotEditsMatchRebuild();
+		void LiveEditsMatchRebuild();
+		void RouterUpdatesMatchRebuild();
+		void TransportRouterUpdatesMatchRebuild();
+		void RouterSettingsMatchRebuild();
+		void RouteMatrixMatchesRoutes();
+		void WeightTypesPrintSameRoutes();
+
+		// every check in turn, one line each; false if any failed
+		bool RunAll(std::ostream& out);
+	}
+}
@@ -0,0 +1,97 @@
+#include "timetable_router.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace transport_catalogue {
+
+	TimetableRouter::TimetableRouter(const TransportCatalogue& catalog, const TransportGraph& graph, const Timetable& timetable)
+		: graph_(graph)
+		, meters_per_minute_(graph.GetSettings().velocity * FACTOR_KM_PER_H_TO_M_PER_MIN) {
+		for (const Bus& bus : catalog.GetAllBuses()) {
+			if (auto it = timetable.find(bus.bus); it != timetable.end()) {
+				AddTrips(catalog, bus, it->second);
+			}
+		}
+		std::stable_sort(connections_.begin(), connections_.end(), [](const Connection& lhs, const Connection& rhs) {
+			return lhs.departure < rhs.departure;
+		});
+	}
+
+	void TimetableRouter::AddTrips(const TransportCatalogue& catalog, const Bus& bus, const std::vector<double>& departures) {
+		std::vector<uint32_t> stops(bus.route.begin(), bus.route.end());
+		if (!bus.is_circle && !stops.empty()) {
+			stops.insert(stops.end(), bus.route.rbegin() + 1, bus.route.rend());
+		}
+		if (stops.size() < 2) {
+			return;
+		}
+
+		// the same ride times for every trip, only the start differs
+		std::vector<double> ride_times;
+		ride_times.reserve(stops.size() - 1);
+		for (size_t i = 0; i + 1 < stops.size(); ++i) {
+			const Stop& from = catalog.GetStopByID(stops[i]);
+			const Stop& to = catalog.GetStopByID(stops[i + 1]);
+			ride_times.push_back(catalog.GetDistance(&from, &to) / meters_per_minute_);
+		}
+
+		for (double departure : departures) {
+			const uint32_t trip = static_cast<uint32_t>(bus_by_trip_.size());
+			bus_by_trip_.push_back(bus.bus);
+			double time = departure;
+			for (size_t i = 0; i + 1 < stops.size(); ++i) {
+				connections_.push_back({
+					static_cast<uint32_t>(graph_.GetStopVertexID(catalog.GetStopByID(stops[i]).stop)),
+					static_cast<uint32_t>(graph_.GetStopVertexID(catalog.GetStopByID(stops[i + 1]).stop)),
+					trip, static_cast<uint32_t>(i), time, time + ride_times[i] });
+				time += ride_times[i];
+			}
+		}
+	}
+
+	std::optional<TimetableRouter::Journey> TimetableRouter::FindEarliestArrival(graph::VertexId from, graph::VertexId to,
+		double departure) const {
+		if (from == to) {
+			return Journey{ departure, departure, {} };
+		}
+
+		const size_t vertex_count = graph_.GetInnerGraph().GetVertexCount();
+		std::vector<double> arrival(vertex_count, std::numeric_limits<double>::infinity());
+		std::vector<std::pair<uint32_t, uint32_t>> ride_by_stop(vertex_count, { NO_CONNECTION, NO_CONNECTION }); // board, alight
+		std::vector<uint32_t> boarding(bus_by_trip_.size(), NO_CONNECTION);
+		arrival[from] = departure;
+
+		auto first = std::lower_bound(connections_.begin(), connections_.end(), departure,
+			[](const Connection& connection, double time) { return connection.departure < time; });
+		for (auto it = first; it != connections_.end() && it->departure <= arrival[to]; ++it) {
+			const Connection& connection = *it;
+			const uint32_t index = static_cast<uint32_t>(it - connections_.begin());
+			if (boarding[connection.trip] == NO_CONNECTION && arrival[connection.from] <= connection.departure) {
+				boarding[connection.trip] = index;
+			}
+			if (boarding[connection.trip] != NO_CONNECTION && connection.arrival < arrival[connection.to]) {
+				arrival[connection.to] = connection.arrival;
+				ride_by_stop[connection.to] = { boarding[connection.trip], index };
+			}
+		}
+		if (ride_by_stop[to].first == NO_CONNECTION) {
+			return std::nullopt;
+		}
+
+		// back from the target, one ride at a time: a wait for the trip, then the ride
+		std::vector<RouteSegment> segments;
+		for (graph::VertexId vertex = to; vertex != from;) {
+			const Connection& board = connections_[ride_by_stop[vertex].first];
+			const Connection& alight = connections_[ride_by_stop[vertex].second];
+			const double ride_time = alight.arrival - board.departure;
+			segments.push_back({ RouteSegment::Type::BUS,
+				std::make_pair(bus_by_trip_[board.trip], static_cast<int>(alight.position - board.position + 1)),
+				ride_time, ride_time * meters_per_minute_ });
+			segments.push_back({ RouteSegment::Type::WAIT, graph_.GetStopName(board.from), board.departure - arrival[board.from] });
+			vertex = board.from;
+		}
+		std::reverse(segments.begin(), segments.end());
+		return Journey{ departure, arrival[to], std::move(segments) };
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace transport_catalogue {
+
+	// departure times of the trips of each bus from its first stop, in minutes; a trip of a bus that is not
+	// a roundtrip rides to the last stop and back
+	using Timetable = std::unordered_map<std::string_view, std::vector<double>>;
+
+	// Earliest-arrival queries over real trips instead of the constant wait model (Connection Scan): every
+	// ride between two neighbouring stops of a trip is a connection, all of them in one flat array sorted
+	// by departure. A query is a single forward scan from the departure time. Trips run at the routing
+	// velocity; changing trains takes no time beyond waiting for the next departure.
+	class TimetableRouter {
+	public:
+		struct Journey {
+			double departure;
+			double arrival;
+			std::vector<RouteSegment> segments; // waits last until the actual departures
+		};
+
+		TimetableRouter(const TransportCatalogue& catalog, const TransportGraph& graph, const Timetable& timetable);
+
+		std::optional<Journey> FindEarliestArrival(graph::VertexId from, graph::VertexId to, double departure) const;
+
+		size_t GetConnectionCount() const {
+			return connections_.size();
+		}
+
+	private:
+		static constexpr uint32_t NO_CONNECTION = std::numeric_limits<uint32_t>::max();
+
+		struct Connection {
+			uint32_t from;
+			uint32_t to;
+			uint32_t trip;
+			uint32_t position; // of the ride within its trip
+			double departure;
+			double arrival;
+		};
+
+		const TransportGraph& graph_;
+		double meters_per_minute_;
+		std::vector<Connection> connections_;
+		std::vector<std::string_view> bus_by_trip_;
+
+		void AddTrips(const TransportCatalogue& catalog, const Bus& bus, const std::vector<double>& departures);
+	};
+}
@@ -1,4 +1,5 @@
 #include "transport_catalogue.h"
+#include <algorithm>
 
 namespace transport_catalogue {
 
@@ -6,20 +7,112 @@ namespace transport_catalogue {
 	using namespace domain;
 	using namespace geo;
 
+	string_view NamePool::Store(string_view name) {
+		if (name.size() > BLOCK_SIZE) {
+			// an oversized name gets a block of its own, the current block stays open
+			auto block = make_unique<char[]>(name.size());
+			char* data = block.get();
+			blocks_.insert(blocks_.empty() ? blocks_.end() : blocks_.end() - 1, move(block));
+			copy(name.begin(), name.end(), data);
+			return { data, name.size() };
+		}
+		if (blocks_.empty() || block_used_ + name.size() > BLOCK_SIZE) {
+			blocks_.push_back(make_unique<char[]>(BLOCK_SIZE));
+			block_used_ = 0;
+		}
+		char* data = blocks_.back().get() + block_used_;
+		copy(name.begin(), name.end(), data);
+		block_used_ += name.size();
+		return { data, name.size() };
+	}
+
+	TransportCatalogue::TransportCatalogue(const TransportCatalogue& other)
+		: names_(other.names_)
+		, stops_(other.stops_)
+		, stops_coordinates_(other.stops_coordinates_)
+		, buses_(other.buses_)
+		, route_pool_(other.route_pool_)
+		, route_pool_unused_(other.route_pool_unused_)
+		, buses_by_stop_(other.buses_by_stop_)
+		, bus_stats_(other.bus_stats_)
+		, spatial_index_(other.spatial_index_, stops_) {
+		// everything pointing into the other catalogue is pointed at the copy
+		stops_by_name_.reserve(stops_.size());
+		for (const Stop& stop : stops_) {
+			stops_by_name_.emplace(stop.stop, &stop);
+		}
+		buses_by_name_.reserve(buses_.size());
+		for (Bus& bus : buses_) {
+			bus.route = bus.route.Rebind(&route_pool_);
+			buses_by_name_.emplace(bus.bus, &bus);
+		}
+		distances_.reserve(other.distances_.size());
+		for (const auto& [stops, distance] : other.distances_) {
+			distances_.emplace(StopPair{ &stops_[stops.first->id], &stops_[stops.second->id] }, distance);
+		}
+	}
+
+	void TransportCatalogue::BulkLoader::Reserve(size_t stop_count, size_t bus_count, size_t route_stop_count, size_t distance_count) {
+		catalogue_.stops_coordinates_.Reserve(catalogue_.stops_.size() + stop_count);
+		catalogue_.stops_by_name_.reserve(catalogue_.stops_by_name_.size() + stop_count);
+		catalogue_.buses_by_name_.reserve(catalogue_.buses_by_name_.size() + bus_count);
+		catalogue_.route_pool_.reserve(catalogue_.route_pool_.size() + route_stop_count);
+		catalogue_.distances_.reserve(catalogue_.distances_.size() + distance_count);
+	}
+
+	const Stop& TransportCatalogue::BulkLoader::AddStop(const Stop& stop) {
+		return catalogue_.PushStop(stop);
+	}
+
+	void TransportCatalogue::BulkLoader::AddBus(string_view bus, const vector<uint32_t>& route, bool is_circle) {
+		catalogue_.PushBus(bus, route, is_circle);
+	}
+
+	void TransportCatalogue::BulkLoader::AddDistance(size_t from_id, size_t to_id, size_t distance) {
+		catalogue_.distances_[{ &catalogue_.stops_[from_id], &catalogue_.stops_[to_id] }] = distance;
+	}
+
+	void TransportCatalogue::BulkLoader::Finalize() {
+		catalogue_.buses_by_stop_.Build(catalogue_.buses_, catalogue_.stops_.size());
+		// the stats of every bus are computed here, once, while the distances are complete; a bus added or
+		// rerouted later computes its own when the edit is applied. benchmark_catalogue times the two
+		catalogue_.bus_stats_.clear();
+		catalogue_.bus_stats_.reserve(catalogue_.buses_.size());
+		for (const Bus& bus : catalogue_.buses_) {
+			catalogue_.bus_stats_.push_back(catalogue_.ComputeBusInfo(bus));
+		}
+		catalogue_.BuildSpatialIndex();
+	}
+
 	void TransportCatalogue::AddStop(const Stop& stop) {
-		stops_.push_back(stop);
+		PushStop(stop);
+		buses_by_stop_.AddStop();
+	}
+
+	void TransportCatalogue::AddBus(string_view bus, const vector<uint32_t>& route, bool is_circle) {
+		const Bus& added_bus = PushBus(bus, route, is_circle);
+		for (uint32_t stop_id : route) {
+			buses_by_stop_.Insert(stop_id, added_bus.id, buses_);
+		}
+		bus_stats_.resize(buses_.size());
+		bus_stats_[added_bus.id] = TryComputeBusInfo(added_bus); // a missing distance fills it in once it is set
+	}
+
+	const Stop& TransportCatalogue::PushStop(const Stop& stop) {
+		stops_.push_back({ names_->Store(stop.stop), stop.coords, stops_.size() });
+		stops_coordinates_.Add(stop.coords);
 		const Stop& added_stop = stops_.back();
 		stops_by_name_[added_stop.stop] = &added_stop;
-		buses_by_stop_[&added_stop] = {};
+		return added_stop;
 	}
 
-	void TransportCatalogue::AddBus(const Bus& bus) {
-		buses_.push_back(bus);
+	const Bus& TransportCatalogue::PushBus(string_view bus, const vector<uint32_t>& route, bool is_circle) {
+		const uint32_t first = static_cast<uint32_t>(route_pool_.size());
+		route_pool_.insert(route_pool_.end(), route.begin(), route.end());
+		buses_.push_back({ names_->Store(bus), RouteView(&route_pool_, first, static_cast<uint32_t>(route_pool_.size())), is_circle, buses_.size() });
 		const Bus& added_bus = buses_.back();
 		buses_by_name_[added_bus.bus] = &added_bus;
-		for (auto stop : bus.route) {
-			buses_by_stop_[stop].insert(added_bus.bus);
-		}
+		return added_bus;
 	}
 
 	optional<const Bus*> TransportCatalogue::FindBusByName(string_view bus) const {
@@ -43,49 +136,199 @@ namespace transport_catalogue {
 		}
 
 		const Bus& found_bus = *opt.value();
+		if (found_bus.id < bus_stats_.size() && bus_stats_[found_bus.id]) {
+			return bus_stats_[found_bus.id];
+		}
+		return ComputeBusInfo(found_bus);
+	}
+
+	BusInfo TransportCatalogue::ComputeBusInfo(const Bus& found_bus) const {
 		size_t stops = 0u;
 		size_t unique_stops = 0u;
 
 		double geo_length = 0.0;
 		size_t route_length = 0u;
 
-		for (size_t i = 0u; i < found_bus.route.size() - 1; ++i) {
-			geo_length += ComputeDistance(found_bus.route.at(i)->coords, found_bus.route.at(i + 1)->coords);
-			route_length += GetDistance(found_bus.route.at(i)->stop, found_bus.route.at(i + 1)->stop);
+		const RouteView& route = found_bus.route;
+		const size_t segments = route.size() - 1;
+		for (size_t i = 0u; i < segments; ++i) {
+			geo_length += ComputeDistance(stops_coordinates_, route[i], route[i + 1]);
+			route_length += GetDistance(&stops_[route[i]], &stops_[route[i + 1]]);
 		}
 
 		if (found_bus.is_circle) {
-			stops = found_bus.route.size();
+			stops = route.size();
 		}
 		else {
-			stops = found_bus.route.size() * 2 - 1;
-			for (size_t i = found_bus.route.size() - 1; i > 0u; --i) {
-				route_length += GetDistance(found_bus.route.at(i)->stop, found_bus.route.at(i - 1)->stop);
+			stops = route.size() * 2 - 1;
+			for (size_t i = route.size() - 1; i > 0u; --i) {
+				route_length += GetDistance(&stops_[route[i]], &stops_[route[i - 1]]);
 			}
 			geo_length *= 2.0;
 		}
 
-		unique_stops = set(found_bus.route.begin(), found_bus.route.end()).size();
+		unique_stops = set(route.begin(), route.end()).size();
 
-		return optional<BusInfo>({ found_bus.bus, stops, unique_stops, route_length, route_length / geo_length });
+		return { found_bus.bus, stops, unique_stops, route_length, route_length / geo_length };
 	}
 
-	optional<set<string_view>> TransportCatalogue::GetBusesByStop(string_view stop) const {
-		if (stops_by_name_.count(stop) == 0) {
+	optional<BusInfo> TransportCatalogue::TryComputeBusInfo(const Bus& bus) const {
+		// from the end: distances tend to come in route order, so a missing one is found at once
+		for (size_t i = bus.route.size(); i > 1u; --i) {
+			const StopPair leg{ &stops_[bus.route[i - 2]], &stops_[bus.route[i - 1]] };
+			const bool is_known = distances_.count(leg) > 0 || distances_.count({ leg.second, leg.first }) > 0;
+			if (!is_known) {
+				return nullopt;
+			}
+		}
+		return ComputeBusInfo(bus);
+	}
+
+	optional<StopBusesView> TransportCatalogue::GetBusesByStop(string_view stop) const {
+		auto it = stops_by_name_.find(stop);
+		if (it == stops_by_name_.end()) {
 			return nullopt;
 		}
-		return {buses_by_stop_.at(stops_by_name_.at(stop))};
+		return buses_by_stop_.GetBuses(it->second->id, buses_);
 	}
 
 	void TransportCatalogue::SetDistance(string_view from, string_view to, size_t distance) {
-		distances_[{ stops_by_name_.at(from), stops_by_name_.at(to) }] = distance;
+		UpdateDistance(from, to, distance);
+	}
+
+	void TransportCatalogue::RemoveBus(string_view bus) {
+		const Bus* removed = buses_by_name_.at(bus);
+		const size_t removed_id = removed->id;
+		for (uint32_t stop_id : removed->route) {
+			buses_by_stop_.Erase(stop_id, removed_id, buses_);
+		}
+		buses_by_name_.erase(removed->bus);
+		const size_t removed_size = removed->route.size();
+
+		// the last bus takes the freed ID; its position in the name-ordered slots stays the same
+		const size_t last_id = buses_.size() - 1;
+		if (removed_id != last_id) {
+			for (uint32_t stop_id : buses_.back().route) {
+				buses_by_stop_.Replace(stop_id, last_id, removed_id);
+			}
+			buses_[removed_id] = buses_.back();
+			buses_[removed_id].id = removed_id;
+			buses_by_name_[buses_[removed_id].bus] = &buses_[removed_id];
+			if (removed_id < bus_stats_.size() && last_id < bus_stats_.size()) {
+				bus_stats_[removed_id] = bus_stats_[last_id];
+			}
+		}
+		buses_.pop_back();
+		bus_stats_.resize(buses_.size());
+		FreeRoute(removed_size);
+	}
+
+	void TransportCatalogue::UpdateBusRoute(string_view bus, const vector<uint32_t>& route, bool is_circle) {
+		Bus& updated = buses_[buses_by_name_.at(bus)->id];
+		for (uint32_t stop_id : updated.route) {
+			buses_by_stop_.Erase(stop_id, updated.id, buses_);
+		}
+
+		// a route that fits is rewritten in place, a longer one moves to the end of the pool
+		const size_t old_size = updated.route.size();
+		uint32_t first = static_cast<uint32_t>(updated.route.begin() - route_pool_.data());
+		if (route.size() > old_size) {
+			first = static_cast<uint32_t>(route_pool_.size());
+			route_pool_.resize(route_pool_.size() + route.size());
+		}
+		copy(route.begin(), route.end(), route_pool_.begin() + first);
+		updated.route = RouteView(&route_pool_, first, first + static_cast<uint32_t>(route.size()));
+		updated.is_circle = is_circle;
+
+		for (uint32_t stop_id : route) {
+			buses_by_stop_.Insert(stop_id, updated.id, buses_);
+		}
+		bus_stats_.resize(buses_.size());
+		bus_stats_[updated.id] = TryComputeBusInfo(updated); // a missing distance fills it in once it is set
+		FreeRoute(route.size() > old_size ? old_size : old_size - route.size());
+	}
+
+	void TransportCatalogue::FreeRoute(size_t size) {
+		route_pool_unused_ += size;
+		if (route_pool_unused_ * 2 <= route_pool_.size()) {
+			return;
+		}
+		// every route again back to back in bus ID order; the views keep pointing at route_pool_
+		vector<uint32_t> pool;
+		pool.reserve(route_pool_.size() - route_pool_unused_);
+		for (Bus& bus : buses_) {
+			const uint32_t first = static_cast<uint32_t>(pool.size());
+			pool.insert(pool.end(), bus.route.begin(), bus.route.end());
+			bus.route = RouteView(&route_pool_, first, static_cast<uint32_t>(pool.size()));
+		}
+		route_pool_ = move(pool);
+		route_pool_unused_ = 0;
+	}
+
+	void TransportCatalogue::MoveStop(string_view stop, Coordinates coords) {
+		Stop& moved = stops_[stops_by_name_.at(stop)->id];
+		moved.coords = coords;
+		stops_coordinates_.Set(moved.id, coords);
+
+		spatial_index_.MoveStop(moved.id);
+		if (spatial_index_.GetMovedCount() * 16 > stops_.size()) {
+			// moved stops are scanned linearly, rebuild the grid before that dominates queries
+			BuildSpatialIndex();
+		}
+		RefreshBusStats(moved.id);
+	}
+
+	void TransportCatalogue::UpdateDistance(string_view from, string_view to, size_t distance) {
+		const Stop* stop_from = stops_by_name_.at(from);
+		const Stop* stop_to = stops_by_name_.at(to);
+		distances_[{ stop_from, stop_to }] = distance;
+		// the distance also serves the opposite direction if that one is not set
+		RefreshBusStats(stop_from, stop_to);
+	}
+
+	void TransportCatalogue::RefreshBusStats(size_t stop_id) {
+		if (bus_stats_.empty()) {
+			return; // no bus yet, or a bulk load before Finalize() builds the index
+		}
+		const auto [first, last] = buses_by_stop_.GetBusIDs(stop_id);
+		for (const uint32_t* bus_id = first; bus_id != last; ++bus_id) {
+			if (*bus_id < bus_stats_.size()) {
+				bus_stats_[*bus_id] = TryComputeBusInfo(buses_[*bus_id]);
+			}
+		}
+	}
+
+	void TransportCatalogue::RefreshBusStats(const Stop* from, const Stop* to) {
+		if (bus_stats_.empty()) {
+			return;
+		}
+		// a bus riding the leg passes through its first stop
+		const auto [first, last] = buses_by_stop_.GetBusIDs(from->id);
+		for (const uint32_t* bus_id = first; bus_id != last; ++bus_id) {
+			const RouteView& route = buses_[*bus_id].route;
+			bool rides_leg = false;
+			for (size_t i = 0u; !rides_leg && i + 1 < route.size(); ++i) {
+				rides_leg = (route[i] == from->id && route[i + 1] == to->id) || (route[i] == to->id && route[i + 1] == from->id);
+			}
+			if (rides_leg && *bus_id < bus_stats_.size()) {
+				bus_stats_[*bus_id] = TryComputeBusInfo(buses_[*bus_id]);
+			}
+		}
 	}
 
 	size_t TransportCatalogue::GetDistance(string_view from, string_view to) const {
-		if (distances_.count({ stops_by_name_.at(from), stops_by_name_.at(to) }) == 0) {
-			return distances_.at({ stops_by_name_.at(to), stops_by_name_.at(from) });
+		return GetDistance(stops_by_name_.at(from), stops_by_name_.at(to));
+	}
+
+	size_t TransportCatalogue::GetDistance(const Stop* from, const Stop* to) const {
+		if (auto it = distances_.find({ from, to }); it != distances_.end()) {
+			return it->second;
 		}
-		return distances_.at({ stops_by_name_.at(from), stops_by_name_.at(to) });
+		return distances_.at({ to, from });
+	}
+
+	const Stop& TransportCatalogue::GetStopByID(size_t id) const {
+		return stops_.at(id);
 	}
 
 	const std::deque<Bus>& TransportCatalogue::GetAllBuses() const {
@@ -95,4 +338,20 @@ namespace transport_catalogue {
 	const std::deque<Stop>& TransportCatalogue::GetAllStops() const {
 		return stops_;
 	}
+
+	const geo::CoordinatesTable& TransportCatalogue::GetStopsCoordinates() const {
+		return stops_coordinates_;
+	}
+
+	void TransportCatalogue::BuildSpatialIndex() {
+		spatial_index_ = SpatialIndex(stops_);
+	}
+
+	std::vector<StopDistance> TransportCatalogue::GetNearestStops(Coordinates point, size_t count) const {
+		return spatial_index_.FindNearest(point, count);
+	}
+
+	std::vector<const Stop*> TransportCatalogue::GetStopsInArea(Coordinates min, Coordinates max) const {
+		return spatial_index_.FindInArea(min, max);
+	}
 }
\ No newline at end of file
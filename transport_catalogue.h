@@ -2,12 +2,15 @@
 
 #include <string>
 #include <deque>
+#include <memory>
 #include <unordered_map>
 #include <optional>
 #include <vector>
 #include <set>
 
 #include "domain.h"
+#include "spatial_index.h"
+#include "stop_buses_index.h"
 
 namespace transport_catalogue {
 	using domain::Stop;
@@ -16,6 +19,18 @@ namespace transport_catalogue {
 
 	using StopPair = std::pair<const Stop*, const Stop*>;
 
+	// append-only character storage: a few large blocks instead of a string per name;
+	// returned views stay valid as long as the pool lives
+	class NamePool {
+	public:
+		std::string_view Store(std::string_view name);
+
+	private:
+		static constexpr size_t BLOCK_SIZE = 64 * 1024;
+		std::vector<std::unique_ptr<char[]>> blocks_;
+		size_t block_used_ = BLOCK_SIZE;
+	};
+
 	class TransportCatalogue {
 	private:
 		struct Hasher {
@@ -26,27 +41,86 @@ namespace transport_catalogue {
 		};
 
 	public:		
+		// loads a whole network at once: hash tables are reserved up front and
+		// the stop->buses index is built in a single pass by Finalize()
+		class BulkLoader {
+		public:
+			explicit BulkLoader(TransportCatalogue& catalogue)
+				: catalogue_(catalogue) {
+			}
+
+			void Reserve(size_t stop_count, size_t bus_count, size_t route_stop_count, size_t distance_count);
+			const Stop& AddStop(const Stop& stop);
+			void AddBus(std::string_view bus, const std::vector<uint32_t>& route, bool is_circle);
+			void AddDistance(size_t from_id, size_t to_id, size_t distance);
+			void Finalize();
+
+		private:
+			TransportCatalogue& catalogue_;
+		};
+
+		TransportCatalogue() = default;
+		// the next version of a catalogue, to apply live changes to: the names are shared with it, so views
+		// taken from either stay valid while any version lives; one version at a time may add names
+		TransportCatalogue(const TransportCatalogue& other);
+		TransportCatalogue& operator=(const TransportCatalogue&) = delete; // buses hold views into route_pool_
+
 		void AddStop(const Stop& stop);
-		void AddBus(const Bus& bus);
+		void AddBus(std::string_view bus, const std::vector<uint32_t>& route, bool is_circle);
 		std::optional<const Stop*> FindStopByName(std::string_view stop) const;
 		std::optional<const Bus*> FindBusByName(std::string_view bus) const;
 		std::optional<BusInfo> GetInfoAboutBus(std::string_view bus) const;
-		std::optional<std::set<std::string_view>> GetBusesByStop(std::string_view stop) const;
+		std::optional<StopBusesView> GetBusesByStop(std::string_view stop) const;
 		void SetDistance(std::string_view from, std::string_view to, size_t distance);
+
+		// live changes: the indexes are patched for the routes involved only
+		void RemoveBus(std::string_view bus);
+		void UpdateBusRoute(std::string_view bus, const std::vector<uint32_t>& route, bool is_circle);
+		void MoveStop(std::string_view stop, geo::Coordinates coords);
+		void UpdateDistance(std::string_view from, std::string_view to, size_t distance);
+
 		size_t GetDistance(std::string_view from, std::string_view to) const;
+		size_t GetDistance(const Stop* from, const Stop* to) const;
+		const Stop& GetStopByID(size_t id) const;
 		const std::deque<Bus>& GetAllBuses() const;
 		const std::deque<Stop>& GetAllStops() const;
+		const geo::CoordinatesTable& GetStopsCoordinates() const; // indexed by stop ID
 		const std::unordered_map<StopPair, size_t, Hasher>& GetAllDistances() const {
 			return distances_;
 		}
+		// entries held, the gaps left by live edits included: stop IDs of the route pool, bus IDs of the stop->buses index
+		size_t GetRoutePoolSize() const {
+			return route_pool_.size();
+		}
+		size_t GetStopBusesIndexSize() const {
+			return buses_by_stop_.GetSize();
+		}
+
+		void BuildSpatialIndex(); // call after all stops are added
+		std::vector<StopDistance> GetNearestStops(geo::Coordinates point, size_t count) const;
+		std::vector<const Stop*> GetStopsInArea(geo::Coordinates min, geo::Coordinates max) const;
 
 	private:		
+		std::shared_ptr<NamePool> names_ = std::make_shared<NamePool>();
 		std::deque<Stop> stops_;
+		geo::CoordinatesTable stops_coordinates_;
 		std::unordered_map<std::string_view, const Stop*> stops_by_name_;
 		std::deque<Bus> buses_;
+		std::vector<uint32_t> route_pool_; // stop IDs of all routes, back to back; replaced routes leave gaps
+		size_t route_pool_unused_ = 0;     // entries in those gaps, packed away once they are half the pool
 		std::unordered_map<std::string_view, const Bus*> buses_by_name_;
-		std::unordered_map<const Stop*, std::set<std::string_view>> buses_by_stop_;
+		StopBusesIndex buses_by_stop_;
+		std::vector<std::optional<BusInfo>> bus_stats_; // by bus ID; empty only while a distance of the route is missing
 		std::unordered_map<StopPair, size_t, Hasher> distances_;
+		SpatialIndex spatial_index_;
+
+		const Stop& PushStop(const Stop& stop);
+		const Bus& PushBus(std::string_view bus, const std::vector<uint32_t>& route, bool is_circle);
+		BusInfo ComputeBusInfo(const Bus& bus) const;
+		std::optional<BusInfo> TryComputeBusInfo(const Bus& bus) const; // std::nullopt if a distance is missing
+		void RefreshBusStats(size_t stop_id);
+		void RefreshBusStats(const Stop* from, const Stop* to); // buses riding the leg either way
+		void FreeRoute(size_t size);
 	};
 
 	namespace tests {
@@ -1,76 +1,751 @@
 #include "transport_router.h"
 
+#include <unordered_set>
+
 namespace transport_catalogue {
 
 	/*------ TransportGraph ------*/
-	const graph::DirectedWeightedGraph<double>& TransportGraph::GetInnerGraph() const {
+	const graph::DirectedWeightedGraph<RouteWeight>& TransportGraph::GetInnerGraph() const {
 		return graph_;
 	}
 
-	size_t TransportGraph::GetAfterWaitingStopID(std::string_view stop_name) const {
-		return TransportGraph::GetNthOdd(id_by_stops_.at(stop_name));
+	size_t TransportGraph::GetStopVertexID(std::string_view stop_name) const {
+		return id_by_stops_.at(stop_name);
 	}
 
-	size_t TransportGraph::GetBeforeWaitingStopID(std::string_view stop_name) const {
-		return TransportGraph::GetNthEven(id_by_stops_.at(stop_name));
+	std::optional<size_t> TransportGraph::FindStopVertexID(std::string_view stop_name) const {
+		if (auto it = id_by_stops_.find(stop_name); it != id_by_stops_.end()) {
+			return it->second;
+		}
+		return std::nullopt;
 	}
 
-	const RouteSegment& TransportGraph::GetSegmentByID(size_t id) const {
-		return segments_.at(id);
+	std::string_view TransportGraph::GetStopName(graph::VertexId stop_vertex) const {
+		return std::get<RouteSegment::WaitData>(wait_segments_.at(stop_vertex).data);
 	}
 
-	size_t TransportGraph::GetNthOdd(size_t stop_id_from_stops_) {
-		return stop_id_from_stops_ * 2 + 1;
+	const RouteSegment& TransportGraph::GetSegmentByID(size_t id) const {
+		return segments_.at(id);
 	}
 
-	size_t TransportGraph::GetNthEven(size_t stop_id_from_stops_) {
-		return stop_id_from_stops_ * 2;
+	const RouteSegment& TransportGraph::GetWaitSegment(graph::VertexId stop_vertex) const {
+		return wait_segments_.at(stop_vertex);
 	}
 
 	void TransportGraph::AddStopsToGraph(const TransportCatalogue& catalog) {
 		const std::deque<Stop>& stops = catalog.GetAllStops();
-		//stops_.reserve(stops.size() * 2);
-		segments_.resize(stops.size());
+		std::vector<const Stop*> order;
+		order.reserve(stops.size());
 		for (const Stop& stop_info : stops) {
-			//stops_.push_back(stop_info.stop);
+			order.push_back(&stop_info);
+		}
+		if (settings_.vertex_order == VertexOrder::HILBERT && !stops.empty()) {
+			geo::Coordinates min = stops.front().coords;
+			geo::Coordinates max = stops.front().coords;
+			for (const Stop& stop_info : stops) {
+				min = { std::min(min.lat, stop_info.coords.lat), std::min(min.lng, stop_info.coords.lng) };
+				max = { std::max(max.lat, stop_info.coords.lat), std::max(max.lng, stop_info.coords.lng) };
+			}
+			std::vector<uint64_t> curve_index(stops.size());
+			for (const Stop& stop_info : stops) {
+				curve_index[stop_info.id] = geo::ComputeHilbertIndex(stop_info.coords, min, max);
+			}
+			std::stable_sort(order.begin(), order.end(), [&curve_index](const Stop* lhs, const Stop* rhs) {
+				return curve_index[lhs->id] < curve_index[rhs->id];
+			});
+		}
 
+		id_by_stops_.reserve(stops.size());
+		for (const Stop* stop_info : order) {
 			size_t id = id_by_stops_.size();
-			id_by_stops_[stop_info.stop] = id;
+			id_by_stops_[stop_info->stop] = id;
+		}
+		AddWaitSegments();
+	}
 
-			size_t segment_id = graph_.AddEdge({ TransportGraph::GetNthEven(id),
-				TransportGraph::GetNthOdd(id),
-				static_cast<double>(settings_.wait_time) });
-			segments_[segment_id] = { RouteSegment::Type::WAIT,
-				stop_info.stop, static_cast<double>(settings_.wait_time) };
+	// the wait items of a route are not edges any more, one shared segment per stop stands for them
+	void TransportGraph::AddWaitSegments() {
+		wait_segments_.resize(id_by_stops_.size());
+		for (const auto& [stop, id] : id_by_stops_) {
+			wait_segments_[id] = { RouteSegment::Type::WAIT, stop, static_cast<double>(settings_.wait_time) };
 		}
 	}
 
 	void TransportGraph::AddBusesToGraph(const TransportCatalogue& catalog) {
 		const std::deque<Bus>& buses = catalog.GetAllBuses();
 		for (const Bus& bus : buses) {
-			AddBusRoute(catalog, bus.bus, bus.route.begin(), bus.route.end());
-			if (!bus.is_circle) {
-				AddBusRoute(catalog, bus.bus, bus.route.rbegin(), bus.route.rend());
+			AddBus(catalog, bus);
+		}
+	}
+
+	std::pair<graph::EdgeId, graph::EdgeId> TransportGraph::AddBus(const TransportCatalogue& catalog, const Bus& bus) {
+		const graph::EdgeId first_edge = graph_.GetEdgeCount();
+		AddBusRoute(catalog, bus.bus, bus.route.begin(), bus.route.end());
+		if (!bus.is_circle) {
+			AddBusRoute(catalog, bus.bus, bus.route.rbegin(), bus.route.rend());
+		}
+		return edges_by_bus_[bus.bus] = { first_edge, graph_.GetEdgeCount() };
+	}
+
+	void TransportGraph::RemoveBus(std::string_view bus) {
+		auto it = edges_by_bus_.find(bus);
+		if (it == edges_by_bus_.end()) {
+			return;
+		}
+		for (graph::EdgeId edge_id = it->second.first; edge_id < it->second.second; ++edge_id) {
+			graph_.DetachEdge(edge_id);
+		}
+		edges_by_bus_.erase(it);
+	}
+
+	bool TransportGraph::UpdateBusTimes(const TransportCatalogue& catalog, const Bus& bus) {
+		graph::EdgeId edge_id = edges_by_bus_.at(bus.bus).first;
+		bool no_time_grew = true;
+		auto update_edge = [this, &edge_id, &no_time_grew](graph::VertexId, graph::VertexId, int, double distance) {
+			double time = GetRideTime(distance);
+			no_time_grew = no_time_grew && time <= segments_[edge_id].time;
+			graph_.SetEdgeWeight(edge_id, GetEdgeWeight(time));
+			segments_[edge_id].time = time;
+			segments_[edge_id].distance = distance;
+			++edge_id;
+		};
+		ForEachRide(catalog, bus.route.begin(), bus.route.end(), update_edge);
+		if (!bus.is_circle) {
+			ForEachRide(catalog, bus.route.rbegin(), bus.route.rend(), update_edge);
+		}
+		return no_time_grew;
+	}
+
+	void TransportGraph::SetSettings(const Settings& settings) {
+		settings_ = settings;
+		for (RouteSegment& segment : wait_segments_) {
+			segment.time = static_cast<double>(settings_.wait_time);
+		}
+		for (graph::EdgeId edge_id = 0; edge_id < segments_.size(); ++edge_id) {
+			RouteSegment& segment = segments_[edge_id];
+			segment.time = GetRideTime(segment.distance);
+			graph_.SetEdgeWeight(edge_id, GetEdgeWeight(segment.time));
+		}
+	}
+
+	std::pair<graph::EdgeId, graph::EdgeId> TransportGraph::GetBusEdges(std::string_view bus) const {
+		return edges_by_bus_.at(bus);
+	}
+
+	// bus edges are added route by route, so each bus owns one contiguous range of edge IDs
+	void TransportGraph::IndexBusEdges() {
+		for (graph::EdgeId edge_id = 0; edge_id < segments_.size(); ++edge_id) {
+			if (segments_[edge_id].type != RouteSegment::Type::BUS) {
+				continue;
+			}
+			std::string_view bus = std::get<RouteSegment::BusData>(segments_[edge_id].data).first;
+			auto [it, inserted] = edges_by_bus_.try_emplace(bus, edge_id, edge_id + 1);
+			if (!inserted) {
+				it->second.second = edge_id + 1;
 			}
 		}
 	}
 
 	/* ------ TransportRouter ------ */
 	std::optional<TransportRouter::TransportRouteInfo> TransportRouter::GetShortestRoute(std::string_view from, std::string_view to) const {
-		size_t from_id = graph_.GetBeforeWaitingStopID(from);
-		size_t to_id = graph_.GetBeforeWaitingStopID(to);
+		size_t from_id = graph_.GetStopVertexID(from);
+		size_t to_id = graph_.GetStopVertexID(to);
+		if (from_id == to_id) {
+			return TransportRouteInfo{ 0.0, {} };
+		}
+		if (components_.IsUnreachable(from_id, to_id)) {
+			return std::nullopt;
+		}
 
-		auto answer = router_.BuildRoute(from_id, to_id);
+		std::optional<graph::Router<RouteWeight>::RouteInfo> route;
+		if (auto it = pinned_rows_.find(from_id); it != pinned_rows_.end()) {
+			if (it->second.weights[to_id] != std::numeric_limits<RouteWeight>::max()) {
+				route = graph::Router<RouteWeight>::RouteInfo{ it->second.weights[to_id], graph::GetTreePath(graph_.GetInnerGraph(), it->second, to_id) };
+			}
+		}
+		else if (tree_cache_) {
+			route = tree_cache_->BuildRoute(from_id, to_id);
+		}
+		else if (alt_router_) {
+			route = alt_router_->BuildRoute(from_id, to_id);
+		}
+		else if (hub_labels_) {
+			route = hub_labels_->BuildRoute(from_id, to_id);
+		}
+		else if (router_) {
+			route = BuildTransferRoute(from_id, to_id);
+		}
+		else if (std::vector<RaptorRouter::Journey> journeys = raptor_router_.FindJourneys(from_id, to_id); !journeys.empty()) {
+			route = graph::Router<RouteWeight>::RouteInfo{ journeys.back().weight, std::move(journeys.back().edges) };
+		}
+		if (!route) {
+			return std::nullopt;
+		}
+		return MakeRouteInfo(route->weight, route->edges);
+	}
 
-		if (!answer) {
+	std::optional<std::vector<TransportRouter::RouteOption>> TransportRouter::GetRouteOptions(std::string_view from,
+		std::string_view to) const {
+		const std::optional<size_t> from_id = graph_.FindStopVertexID(from);
+		const std::optional<size_t> to_id = graph_.FindStopVertexID(to);
+		if (!from_id || !to_id || components_.IsUnreachable(*from_id, *to_id)) {
 			return std::nullopt;
 		}
+		const std::vector<RaptorRouter::Journey> journeys = raptor_router_.FindJourneys(*from_id, *to_id);
+		if (journeys.empty()) {
+			return std::nullopt;
+		}
+		std::vector<RouteOption> options;
+		options.reserve(journeys.size());
+		for (const RaptorRouter::Journey& journey : journeys) {
+			options.push_back({ MakeRouteInfo(journey.weight, journey.edges), journey.transfers });
+		}
+		return options;
+	}
 
+	// every ride edge is a wait at its first stop followed by the ride itself
+	TransportRouter::TransportRouteInfo TransportRouter::MakeRouteInfo(RouteWeight weight, const std::vector<graph::EdgeId>& edges) const {
+		const auto& graph = graph_.GetInnerGraph();
 		std::vector<const RouteSegment*> result;
-		result.reserve(answer->edges.size());
-		for (auto edge_id : answer->edges) {
+		result.reserve(edges.size() * 2);
+		for (auto edge_id : edges) {
+			result.push_back(&graph_.GetWaitSegment(graph.GetEdge(edge_id).from));
 			result.push_back(&graph_.GetSegmentByID(edge_id));
 		}
-		return TransportRouteInfo{ answer->weight, result };
+		// the total converts the weight the route was chosen by, as the matrix and the isochrones do; the segments
+		// keep the exact minutes, off the total by no more than the 2^-32 minute rounding of each ride
+		return TransportRouteInfo{ ToMinutes(weight), result };
+	}
+
+	std::optional<graph::Router<RouteWeight>::RouteInfo> TransportRouter::BuildTransferRoute(graph::VertexId from_id,
+		graph::VertexId to_id) const {
+		const auto& graph = graph_.GetInnerGraph();
+
+		// a single ride, or a ride to a transfer stop, the precomputed part and a ride from a transfer stop
+		RouteChoice choice;
+		for (graph::EdgeId edge_id : graph.GetIncidentEdges(from_id)) {
+			const auto& edge = graph.GetEdge(edge_id);
+			if (edge.to == to_id && edge.weight < choice.weight) {
+				choice.weight = edge.weight;
+				choice.direct = edge_id;
+			}
+		}
+		const std::vector<TransferLink> exits = GetExits(from_id);
+		const std::vector<TransferLink> entries = GetEntries(to_id);
+		ChooseTransferRoute(exits, entries, choice);
+
+		if (!choice.direct && choice.exit == NO_TRANSFER) {
+			return std::nullopt;
+		}
+
+		std::vector<graph::EdgeId> edges;
+		if (choice.direct) {
+			edges.push_back(*choice.direct);
+		}
+		else {
+			const TransferLink& exit = exits[choice.exit];
+			const TransferLink& entry = entries[choice.entry];
+			if (exit.edge) {
+				edges.push_back(*exit.edge);
+			}
+			const auto transfer_route = router_->BuildRoute(exit.transfer, entry.transfer);
+			for (graph::EdgeId reduced_id : transfer_route->edges) {
+				edges.push_back(edge_by_reduced_[reduced_id]);
+			}
+			if (entry.edge) {
+				edges.push_back(*entry.edge);
+			}
+		}
+		return graph::Router<RouteWeight>::RouteInfo{ choice.weight, std::move(edges) };
+	}
+
+	std::vector<std::vector<std::optional<double>>> TransportRouter::GetRouteMatrix(const std::vector<std::string_view>& from,
+		const std::vector<std::string_view>& to) const {
+		const auto& graph = graph_.GetInnerGraph();
+		std::vector<std::vector<std::optional<double>>> times(from.size(), std::vector<std::optional<double>>(to.size()));
+
+		std::vector<std::optional<size_t>> to_ids;
+		to_ids.reserve(to.size());
+		for (std::string_view stop : to) {
+			to_ids.push_back(graph_.FindStopVertexID(stop));
+		}
+
+		if (!router_ && !hub_labels_) {
+			// no table or labels to look up: one search from each origin settles every destination at once
+			RunParallel(from.size(), [&](size_t row) {
+				const std::optional<size_t> from_id = graph_.FindStopVertexID(from[row]);
+				if (!from_id) {
+					return;
+				}
+				std::shared_ptr<const graph::ShortestPathTree<RouteWeight>> cached_tree;
+				const graph::ShortestPathTree<RouteWeight>* tree = nullptr;
+				if (auto it = pinned_rows_.find(*from_id); it != pinned_rows_.end()) {
+					tree = &it->second;
+				}
+				else if (tree_cache_) {
+					cached_tree = tree_cache_->GetTree(*from_id);
+					tree = cached_tree.get();
+				}
+				if (tree) {
+					for (size_t col = 0; col < to.size(); ++col) {
+						if (to_ids[col] && tree->weights[*to_ids[col]] != std::numeric_limits<RouteWeight>::max()) {
+							times[row][col] = ToMinutes(tree->weights[*to_ids[col]]);
+						}
+					}
+					return;
+				}
+				std::vector<std::optional<double>> time_by_vertex(graph.GetVertexCount());
+				for (const auto& [vertex, weight] : graph::FindReachable(graph, *from_id, std::numeric_limits<RouteWeight>::max())) {
+					time_by_vertex[vertex] = ToMinutes(weight);
+				}
+				for (size_t col = 0; col < to.size(); ++col) {
+					if (to_ids[col]) {
+						times[row][col] = time_by_vertex[*to_ids[col]];
+					}
+				}
+			});
+			return times;
+		}
+
+		if (hub_labels_) {
+			RunParallel(from.size(), [&](size_t row) {
+				const std::optional<size_t> from_id = graph_.FindStopVertexID(from[row]);
+				for (size_t col = 0; from_id && col < to.size(); ++col) {
+					if (to_ids[col] && !components_.IsUnreachable(*from_id, *to_ids[col])) {
+						if (const std::optional<RouteWeight> weight = hub_labels_->GetDistance(*from_id, *to_ids[col])) {
+							times[row][col] = ToMinutes(*weight);
+						}
+					}
+				}
+			});
+			return times;
+		}
+
+		// links into the transfer stops are looked up once per destination
+		std::vector<std::vector<TransferLink>> entries;
+		entries.reserve(to.size());
+		for (const std::optional<size_t>& to_id : to_ids) {
+			entries.push_back(to_id ? GetEntries(*to_id) : std::vector<TransferLink>{});
+		}
+
+		auto fill_row = [&](size_t row) {
+			const std::optional<size_t> from_id = graph_.FindStopVertexID(from[row]);
+			if (!from_id) {
+				return;
+			}
+			std::unordered_map<graph::VertexId, graph::EdgeId> direct_rides; // the fastest one to each stop
+			for (graph::EdgeId edge_id : graph.GetIncidentEdges(*from_id)) {
+				const auto& edge = graph.GetEdge(edge_id);
+				auto [it, inserted] = direct_rides.emplace(edge.to, edge_id);
+				if (edge.weight < graph.GetEdge(it->second).weight) {
+					it->second = edge_id;
+				}
+			}
+			const std::vector<TransferLink> exits = GetExits(*from_id);
+
+			for (size_t col = 0; col < to.size(); ++col) {
+				if (!to_ids[col]) {
+					continue;
+				}
+				if (*to_ids[col] == *from_id) {
+					times[row][col] = 0.0;
+					continue;
+				}
+				if (components_.IsUnreachable(*from_id, *to_ids[col])) {
+					continue;
+				}
+				RouteChoice choice;
+				if (auto it = direct_rides.find(*to_ids[col]); it != direct_rides.end()) {
+					choice.weight = graph.GetEdge(it->second).weight;
+					choice.direct = it->second;
+				}
+				ChooseTransferRoute(exits, entries[col], choice);
+				if (choice.direct || choice.exit != NO_TRANSFER) {
+					times[row][col] = ToMinutes(choice.weight);
+				}
+			}
+		};
+
+		RunParallel(from.size(), fill_row);
+		return times;
+	}
+
+	std::vector<std::optional<std::vector<TransportRouter::ReachableStop>>> TransportRouter::GetReachableStops(
+		const std::vector<std::pair<std::string_view, double>>& origins) const {
+		std::vector<std::optional<std::vector<ReachableStop>>> result(origins.size());
+		RunParallel(origins.size(), [&](size_t i) {
+			const auto [stop, max_time] = origins[i];
+			const std::optional<size_t> from_id = graph_.FindStopVertexID(stop);
+			if (!from_id) {
+				return;
+			}
+			std::vector<ReachableStop>& reachable = result[i].emplace();
+			for (const auto& [vertex, weight] : graph::FindReachable(graph_.GetInnerGraph(), *from_id, ToRouteWeight(max_time))) {
+				reachable.push_back({ graph_.GetStopName(vertex), ToMinutes(weight) });
+			}
+			// settled by time already; stops reached at the same time go by name
+			std::stable_sort(reachable.begin(), reachable.end(), [](const ReachableStop& lhs, const ReachableStop& rhs) {
+				return lhs.time < rhs.time || (lhs.time == rhs.time && lhs.stop < rhs.stop);
+			});
+		});
+		return result;
+	}
+
+	TransportRouter::TransportRouter(const TransportRouter& other)
+		: graph_(other.graph_)
+		, raptor_router_(graph_, other.raptor_router_)
+		, thread_count_(other.thread_count_)
+		, transfer_by_vertex_(other.transfer_by_vertex_)
+		, incoming_edges_(other.incoming_edges_)
+		, reduced_by_edge_(other.reduced_by_edge_)
+		, edge_by_reduced_(other.edge_by_reduced_)
+		, transfer_graph_(other.transfer_graph_)
+		, pinned_rows_(other.pinned_rows_)
+		, components_(other.components_) {
+		// the engines keep references to their graphs: each one is pointed at the copy
+		if (other.router_) {
+			router_.emplace(transfer_graph_, *other.router_);
+		}
+		if (other.alt_router_) {
+			alt_router_.emplace(graph_.GetInnerGraph(), *other.alt_router_);
+		}
+		if (other.hub_labels_) {
+			hub_labels_.emplace(graph_.GetInnerGraph(), *other.hub_labels_);
+		}
+		CreateTreeCache();
+	}
+
+	void TransportRouter::SetThreadCount(size_t thread_count) {
+		thread_count_ = std::max<size_t>(thread_count, 1);
+	}
+
+	void TransportRouter::SetSettings(const TransportGraph::Settings& settings) {
+		const TransportGraph::Settings previous = graph_.GetSettings();
+		graph_.SetSettings(settings);
+		CopyWeightsToTransferGraph();
+		if (settings.engine != previous.engine
+			|| (settings.engine == RouteEngine::ALT && settings.landmark_count != previous.landmark_count)
+			|| (settings.engine == RouteEngine::TRANSFER_TABLE && (settings.max_router_memory_mb != previous.max_router_memory_mb
+				|| settings.frequent_stops != previous.frequent_stops))) {
+			CreateEngine();
+		}
+		else {
+			RebuildEngine();
+			if (settings.tree_cache_size != previous.tree_cache_size) {
+				CreateTreeCache();
+			}
+		}
+	}
+
+	void TransportRouter::CreateEngine() {
+		router_.reset();
+		alt_router_.reset();
+		hub_labels_.reset();
+		pinned_rows_.clear();
+		components_ = graph::FindStronglyConnectedComponents(graph_.GetInnerGraph());
+		if (graph_.GetSettings().engine == RouteEngine::ALT) {
+			alt_router_.emplace(graph_.GetInnerGraph(), graph_.GetSettings().landmark_count);
+		}
+		else if (graph_.GetSettings().engine == RouteEngine::HUB_LABELS) {
+			hub_labels_.emplace(graph_.GetInnerGraph());
+		}
+		else if (graph_.GetSettings().engine == RouteEngine::TRANSFER_TABLE) {
+			if (IsTableWithinBudget()) {
+				router_.emplace(transfer_graph_);
+			}
+			else {
+				PinRows();
+			}
+		}
+		CreateTreeCache();
+	}
+
+	void TransportRouter::RebuildEngine() {
+		components_ = graph::FindStronglyConnectedComponents(graph_.GetInnerGraph());
+		if (router_) {
+			router_->Rebuild();
+		}
+		else if (alt_router_) {
+			alt_router_->Rebuild();
+		}
+		else if (hub_labels_) {
+			hub_labels_->Rebuild();
+		}
+		else if (graph_.GetSettings().engine == RouteEngine::TRANSFER_TABLE) {
+			PinRows();
+		}
+		if (tree_cache_) {
+			tree_cache_->Clear();
+		}
+	}
+
+	// the engines that search per query; a table or labels answer faster than a cached tree
+	void TransportRouter::CreateTreeCache() {
+		tree_cache_.reset();
+		if (graph_.GetSettings().tree_cache_size > 0 && !router_ && !hub_labels_) {
+			tree_cache_.emplace(graph_.GetInnerGraph(), graph_.GetSettings().tree_cache_size);
+		}
+	}
+
+	bool TransportRouter::IsTableWithinBudget() const {
+		const size_t budget = graph_.GetSettings().max_router_memory_mb;
+		const size_t transfer_count = transfer_graph_.GetVertexCount();
+		return budget == 0 || transfer_count * transfer_count * sizeof(graph::Router<RouteWeight>::RoutesInternalData::value_type::value_type)
+			<= budget * BYTES_PER_MB;
+	}
+
+	void TransportRouter::PinRows() {
+		pinned_rows_.clear();
+		const auto& graph = graph_.GetInnerGraph();
+		const size_t row_size = graph.GetVertexCount() * (sizeof(RouteWeight) + sizeof(graph::EdgeId));
+		if (row_size == 0) {
+			return;
+		}
+		const size_t row_count = std::min(graph_.GetSettings().max_router_memory_mb * BYTES_PER_MB / row_size, graph.GetVertexCount());
+		const std::vector<graph::VertexId> origins = RankOrigins();
+		std::vector<graph::ShortestPathTree<RouteWeight>> rows(row_count);
+		RunParallel(row_count, [&](size_t i) {
+			rows[i] = graph::BuildShortestPathTree(graph, origins[i]);
+		});
+		for (graph::ShortestPathTree<RouteWeight>& row : rows) {
+			const graph::VertexId origin = row.source;
+			pinned_rows_.emplace(origin, std::move(row));
+		}
+	}
+
+	// the stops of the query log first, then by the buses through them: each bus direction leaving a stop has
+	// exactly one ride to the next stop
+	std::vector<graph::VertexId> TransportRouter::RankOrigins() const {
+		const auto& graph = graph_.GetInnerGraph();
+		std::vector<size_t> bus_count(graph.GetVertexCount(), 0);
+		for (graph::VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+			for (graph::EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+				const RouteSegment& segment = graph_.GetSegmentByID(edge_id);
+				if (segment.type == RouteSegment::Type::BUS && std::get<RouteSegment::BusData>(segment.data).second == 1) {
+					++bus_count[vertex];
+				}
+			}
+		}
+
+		std::vector<graph::VertexId> origins;
+		origins.reserve(graph.GetVertexCount());
+		std::vector<bool> is_ranked(graph.GetVertexCount(), false);
+		for (const std::string& stop : graph_.GetSettings().frequent_stops) {
+			if (const std::optional<size_t> vertex = graph_.FindStopVertexID(stop); vertex && !is_ranked[*vertex]) {
+				is_ranked[*vertex] = true;
+				origins.push_back(*vertex);
+			}
+		}
+		const size_t logged = origins.size();
+		for (graph::VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+			if (!is_ranked[vertex]) {
+				origins.push_back(vertex);
+			}
+		}
+		std::stable_sort(origins.begin() + logged, origins.end(),
+			[&bus_count](graph::VertexId lhs, graph::VertexId rhs) { return bus_count[lhs] > bus_count[rhs]; });
+		return origins;
+	}
+
+	std::optional<graph::ShortestPathTreeCache<RouteWeight>::Stats> TransportRouter::GetTreeCacheStats() const {
+		if (!tree_cache_) {
+			return std::nullopt;
+		}
+		return tree_cache_->GetStats();
+	}
+
+	void TransportRouter::AddBus(const TransportCatalogue& catalog, std::string_view bus) {
+		const auto [first_edge, last_edge] = graph_.AddBus(catalog, **catalog.FindBusByName(bus));
+		raptor_router_.Rebuild(catalog);
+		components_ = graph::FindStronglyConnectedComponents(graph_.GetInnerGraph());
+
+		const std::vector<bool> is_transfer = FindTransferStops(catalog);
+		for (graph::VertexId vertex = 0; vertex < is_transfer.size(); ++vertex) {
+			if (is_transfer[vertex] != (transfer_by_vertex_[vertex] != NO_TRANSFER)) {
+				Reduce(catalog); // the bus made new transfer stops
+				return;
+			}
+		}
+
+		reduced_by_edge_.resize(graph_.GetInnerGraph().GetEdgeCount(), NO_TRANSFER);
+		const graph::EdgeId first_reduced = transfer_graph_.GetEdgeCount();
+		for (graph::EdgeId edge_id = first_edge; edge_id < last_edge; ++edge_id) {
+			AddToTransferGraph(transfer_graph_, edge_id);
+		}
+		if (!router_) {
+			RebuildEngine();
+			return;
+		}
+		router_->UpdateWithEdges(first_reduced, transfer_graph_.GetEdgeCount());
+	}
+
+	void TransportRouter::RemoveBus(const TransportCatalogue& catalog, std::string_view bus) {
+		graph_.RemoveBus(bus);
+		raptor_router_.Rebuild(catalog);
+		Reduce(catalog);
+	}
+
+	void TransportRouter::UpdateBusRoute(const TransportCatalogue& catalog, std::string_view bus) {
+		graph_.RemoveBus(bus);
+		graph_.AddBus(catalog, **catalog.FindBusByName(bus));
+		raptor_router_.Rebuild(catalog);
+		Reduce(catalog);
+	}
+
+	void TransportRouter::UpdateDistance(const TransportCatalogue& catalog, std::string_view from, std::string_view to) {
+		// buses through either stop may ride the changed leg, the distance serves both directions if unset
+		std::unordered_set<std::string_view> buses;
+		for (std::string_view stop : { from, to }) {
+			const StopBusesView stop_buses = *catalog.GetBusesByStop(stop);
+			for (std::string_view bus : stop_buses) {
+				buses.insert(bus);
+			}
+		}
+		bool no_time_grew = true;
+		std::vector<graph::EdgeId> changed;
+		for (std::string_view bus : buses) {
+			no_time_grew = graph_.UpdateBusTimes(catalog, **catalog.FindBusByName(bus)) && no_time_grew;
+			const auto [first_edge, last_edge] = graph_.GetBusEdges(bus);
+			for (graph::EdgeId edge_id = first_edge; edge_id < last_edge; ++edge_id) {
+				if (reduced_by_edge_[edge_id] != NO_TRANSFER) {
+					transfer_graph_.SetEdgeWeight(reduced_by_edge_[edge_id], graph_.GetInnerGraph().GetEdge(edge_id).weight);
+					changed.push_back(reduced_by_edge_[edge_id]);
+				}
+			}
+		}
+
+		if (!no_time_grew || !router_) {
+			RebuildEngine();
+			return;
+		}
+		for (graph::EdgeId reduced_id : changed) {
+			router_->UpdateWithEdges(reduced_id, reduced_id + 1);
+		}
+	}
+
+	std::vector<bool> TransportRouter::FindTransferStops(const TransportCatalogue& catalog) const {
+		const size_t vertex_count = graph_.GetInnerGraph().GetVertexCount();
+		std::vector<bool> is_transfer(vertex_count, false);
+		std::vector<size_t> last_bus(vertex_count, NO_TRANSFER);
+
+		for (const Bus& bus : catalog.GetAllBuses()) {
+			if (bus.route.empty()) {
+				continue;
+			}
+			is_transfer[graph_.GetStopVertexID(catalog.GetStopByID(bus.route.front()).stop)] = true;
+			is_transfer[graph_.GetStopVertexID(catalog.GetStopByID(bus.route.back()).stop)] = true;
+			for (uint32_t stop_id : bus.route) {
+				const size_t vertex = graph_.GetStopVertexID(catalog.GetStopByID(stop_id).stop);
+				// a second bus, or the same bus for the second time
+				if (last_bus[vertex] != NO_TRANSFER) {
+					is_transfer[vertex] = true;
+				}
+				last_bus[vertex] = bus.id;
+			}
+		}
+		return is_transfer;
+	}
+
+	graph::DirectedWeightedGraph<RouteWeight> TransportRouter::BuildTransferGraph(const TransportCatalogue& catalog) {
+		const auto& graph = graph_.GetInnerGraph();
+		const std::vector<bool> is_transfer = FindTransferStops(catalog);
+
+		size_t transfer_count = 0;
+		transfer_by_vertex_.assign(graph.GetVertexCount(), NO_TRANSFER);
+		for (graph::VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+			if (is_transfer[vertex]) {
+				transfer_by_vertex_[vertex] = transfer_count++;
+			}
+		}
+
+		// edges detached by live changes are not in the incidence lists
+		std::vector<bool> is_attached(graph.GetEdgeCount(), false);
+		for (graph::VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+			for (graph::EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+				is_attached[edge_id] = true;
+			}
+		}
+
+		graph::DirectedWeightedGraph<RouteWeight> transfer_graph(transfer_count);
+		incoming_edges_.assign(graph.GetVertexCount(), {});
+		reduced_by_edge_.assign(graph.GetEdgeCount(), NO_TRANSFER);
+		edge_by_reduced_.clear();
+		for (graph::EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+			if (is_attached[edge_id]) {
+				AddToTransferGraph(transfer_graph, edge_id);
+			}
+		}
+		return transfer_graph;
+	}
+
+	void TransportRouter::AddToTransferGraph(graph::DirectedWeightedGraph<RouteWeight>& transfer_graph, graph::EdgeId edge_id) {
+		const auto& edge = graph_.GetInnerGraph().GetEdge(edge_id);
+		if (transfer_by_vertex_[edge.to] == NO_TRANSFER) {
+			incoming_edges_[edge.to].push_back(edge_id);
+			return;
+		}
+		if (transfer_by_vertex_[edge.from] == NO_TRANSFER) {
+			return;
+		}
+		reduced_by_edge_[edge_id] = transfer_graph.AddEdge({ transfer_by_vertex_[edge.from],
+			transfer_by_vertex_[edge.to], edge.weight });
+		edge_by_reduced_.push_back(edge_id);
+	}
+
+	void TransportRouter::Reduce(const TransportCatalogue& catalog) {
+		transfer_graph_ = BuildTransferGraph(catalog);
+		RebuildEngine();
+	}
+
+	void TransportRouter::CopyWeightsToTransferGraph() {
+		for (graph::EdgeId reduced_id = 0; reduced_id < edge_by_reduced_.size(); ++reduced_id) {
+			transfer_graph_.SetEdgeWeight(reduced_id, graph_.GetInnerGraph().GetEdge(edge_by_reduced_[reduced_id]).weight);
+		}
+	}
+
+	std::vector<TransportRouter::TransferLink> TransportRouter::GetExits(graph::VertexId from) const {
+		if (transfer_by_vertex_[from] != NO_TRANSFER) {
+			return { { transfer_by_vertex_[from], std::nullopt, RouteWeight{} } };
+		}
+		const auto& graph = graph_.GetInnerGraph();
+		std::vector<TransferLink> exits;
+		for (graph::EdgeId edge_id : graph.GetIncidentEdges(from)) {
+			const auto& edge = graph.GetEdge(edge_id);
+			if (transfer_by_vertex_[edge.to] != NO_TRANSFER) {
+				exits.push_back({ transfer_by_vertex_[edge.to], edge_id, edge.weight });
+			}
+		}
+		return exits;
+	}
+
+	void TransportRouter::ChooseTransferRoute(const std::vector<TransferLink>& exits, const std::vector<TransferLink>& entries,
+		RouteChoice& choice) const {
+		for (size_t exit = 0; exit < exits.size(); ++exit) {
+			for (size_t entry = 0; entry < entries.size(); ++entry) {
+				const auto& route = router_->GetRouteInternalData(exits[exit].transfer, entries[entry].transfer);
+				if (!route) {
+					continue;
+				}
+				const RouteWeight weight = exits[exit].weight + route->weight + entries[entry].weight;
+				if (weight < choice.weight) {
+					choice = { weight, std::nullopt, exit, entry };
+				}
+			}
+		}
+	}
+
+	std::vector<TransportRouter::TransferLink> TransportRouter::GetEntries(graph::VertexId to) const {
+		if (transfer_by_vertex_[to] != NO_TRANSFER) {
+			return { { transfer_by_vertex_[to], std::nullopt, RouteWeight{} } };
+		}
+		const auto& graph = graph_.GetInnerGraph();
+		std::vector<TransferLink> entries;
+		for (graph::EdgeId edge_id : incoming_edges_[to]) {
+			const auto& edge = graph.GetEdge(edge_id);
+			if (transfer_by_vertex_[edge.from] != NO_TRANSFER) {
+				entries.push_back({ transfer_by_vertex_[edge.from], edge_id, edge.weight });
+			}
+		}
+		return entries;
 	}
 }
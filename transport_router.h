@@ -2,14 +2,49 @@
 #include "transport_catalogue.h"
 #include "graph.h"
 #include "router.h"
+#include "alt_router.h"
+#include "hub_labels.h"
+#include "raptor_router.h"
+#include "dijkstra.h"
+#include "components.h"
+#include "path_tree_cache.h"
+#include "route_weight.h"
 
 #include <vector>
+#include <string>
 #include <string_view>
+#include <unordered_map>
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <limits>
+#include <optional>
+#include <thread>
+#include <type_traits>
 
 namespace transport_catalogue {
 
 	constexpr double FACTOR_KM_PER_H_TO_M_PER_MIN = 1000.0 / 60.0;
+	constexpr size_t PARALLEL_MIN_ORIGINS = 16; // smaller batches of searches are not worth the threads
+	constexpr size_t BYTES_PER_MB = 1024 * 1024;
+
+	// how point-to-point routes are found: a precomputed table among the transfer stops, an on-line
+	// search guided by landmarks with linear memory, an intersection of two hub labels, or rounds over
+	// the bus routes with nothing precomputed
+	enum class RouteEngine {
+		TRANSFER_TABLE,
+		ALT,
+		HUB_LABELS,
+		RAPTOR
+	};
+
+	// how stops are numbered as vertices: as the catalogue lists them, or along a Hilbert curve over their
+	// coordinates so that stops close on the map lie close in every per-vertex array
+	enum class VertexOrder {
+		CATALOGUE,
+		HILBERT
+	};
 
 	struct RouteSegment {
 
@@ -23,6 +58,7 @@ namespace transport_catalogue {
 		using BusData = std::pair<std::string_view, int>;
 		std::variant<WaitData, BusData> data;
 		double time;
+		double distance = 0.0; // meters ridden, BUS only; time is derived from it and the settings
 	};
 
 	class TransportGraph {
@@ -30,11 +66,17 @@ namespace transport_catalogue {
 		struct Settings {
 			int wait_time;
 			double velocity;
+			RouteEngine engine = RouteEngine::TRANSFER_TABLE;
+			size_t landmark_count = 16; // ALT only
+			size_t tree_cache_size = 0; // engines searching per query: origins whose shortest path trees are kept, 0 for none
+			size_t max_router_memory_mb = 0; // TRANSFER_TABLE: 0 for no limit
+			std::vector<std::string> frequent_stops = {}; // origins to precompute first, most frequent first
+			VertexOrder vertex_order = VertexOrder::HILBERT; // applied when the graph is built
 		};
 		
 		template <typename T>
 		TransportGraph(const TransportCatalogue& catalog, T&& settings)
-			: settings_(std::forward<T>(settings)), graph_(catalog.GetAllStops().size() * 2) {
+			: settings_(std::forward<T>(settings)), graph_(catalog.GetAllStops().size()) {
 			AddStopsToGraph(catalog);
 			AddBusesToGraph(catalog);
 		}
@@ -47,104 +89,271 @@ namespace transport_catalogue {
 			, id_by_stops_(std::forward<Ids>(id_by_stops))
 			, segments_(std::forward<Segments>(segments))
 		{
-
+			AddWaitSegments();
+			IndexBusEdges();
 		}
 
 		const Settings& GetSettings() const {
 			return settings_;
 		}
+		// same topology, new times: every edge weight is recomputed in one pass over the segments
+		void SetSettings(const Settings& settings);
 
 		size_t GetSegmentCount() const {
 			return segments_.size();
 		}
 		/* -------------------- */
 
-		const graph::DirectedWeightedGraph<double>& GetInnerGraph() const;
+		const graph::DirectedWeightedGraph<RouteWeight>& GetInnerGraph() const;
 
-		size_t GetAfterWaitingStopID(std::string_view stop_name) const;  // id * 2 + 1
-		size_t GetBeforeWaitingStopID(std::string_view stop_name) const; // id * 2
+		size_t GetStopVertexID(std::string_view stop_name) const;
+		std::string_view GetStopName(graph::VertexId stop_vertex) const;
+		std::optional<size_t> FindStopVertexID(std::string_view stop_name) const;
 		const RouteSegment& GetSegmentByID(size_t id) const;
+		const RouteSegment& GetWaitSegment(graph::VertexId stop_vertex) const;
+
+		// live changes of the catalogue, patching the edges of one bus; routes have to be recomputed after
+		std::pair<graph::EdgeId, graph::EdgeId> AddBus(const TransportCatalogue& catalog, const Bus& bus); // new edges
+		void RemoveBus(std::string_view bus);
+		bool UpdateBusTimes(const TransportCatalogue& catalog, const Bus& bus); // same route, new distances; false if any time grew
+		std::pair<graph::EdgeId, graph::EdgeId> GetBusEdges(std::string_view bus) const;
 
 	private:
 		Settings settings_;
-		graph::DirectedWeightedGraph<double> graph_;
+		graph::DirectedWeightedGraph<RouteWeight> graph_;
 		std::unordered_map<std::string_view, size_t> id_by_stops_ = {};
-		std::vector<RouteSegment> segments_ = {};
-
-		static size_t GetNthOdd(size_t stop_id_from_stops_);
-		static size_t GetNthEven(size_t stop_id_from_stops_);
+		std::vector<RouteSegment> segments_ = {};      // BUS, by edge ID
+		std::vector<RouteSegment> wait_segments_ = {}; // WAIT, by stop vertex
+		std::unordered_map<std::string_view, std::pair<graph::EdgeId, graph::EdgeId>> edges_by_bus_ = {}; // [first, last)
 
 		void AddStopsToGraph(const TransportCatalogue& catalog);
+		void AddWaitSegments();
 
-		template <typename It>
-		void AddBusRoute(const TransportCatalogue& catalog, std::string_view bus, It first, It last) {
-			size_t stops_count = last - first;
-			segments_.resize(segments_.size() + (stops_count - 1) * stops_count / 2);
+		void IndexBusEdges();
 
+		double GetRideTime(double distance) const {
+			return distance / (settings_.velocity * FACTOR_KM_PER_H_TO_M_PER_MIN);
+		}
+		// one vertex per stop: the wait before boarding is part of every ride edge
+		RouteWeight GetEdgeWeight(double ride_time) const {
+			return ToRouteWeight(settings_.wait_time + ride_time);
+		}
+
+		// calls ride(from_vertex, to_vertex, span_count, distance) for every pair of stops along the route, in edge order
+		template <typename It, typename Ride>
+		void ForEachRide(const TransportCatalogue& catalog, It first, It last, Ride ride) const {
 			for (auto from = first; from < last - 1; ++from) {
-				std::string_view stop_from_name = (*from)->stop;
-				size_t stop_from_id = id_by_stops_[stop_from_name];
+				const Stop* stop_from = &catalog.GetStopByID(*from);
+				size_t stop_from_id = id_by_stops_.at(stop_from->stop);
 
-				std::string_view last_stop_name = stop_from_name;
+				const Stop* last_stop = stop_from;
 				double distance = 0.0;
 
 				for (auto to = from + 1; to < last; ++to) {
-					std::string_view stop_to_name = (*to)->stop;
-					size_t stop_to_id = id_by_stops_[stop_to_name];
-
-					distance += catalog.GetDistance(last_stop_name, stop_to_name);
-					last_stop_name = stop_to_name;
-					double time = distance / (settings_.velocity * FACTOR_KM_PER_H_TO_M_PER_MIN);
-
-					size_t segment_id = graph_.AddEdge({ TransportGraph::GetNthOdd(stop_from_id),
-						TransportGraph::GetNthEven(stop_to_id),
-						time });
-					segments_[segment_id] = { RouteSegment::Type::BUS,
-						std::make_pair(bus, to - from), time };
+					const Stop* stop_to = &catalog.GetStopByID(*to);
+					size_t stop_to_id = id_by_stops_.at(stop_to->stop);
+
+					distance += catalog.GetDistance(last_stop, stop_to);
+					last_stop = stop_to;
+
+					ride(stop_from_id, stop_to_id, static_cast<int>(to - from), distance);
 				}
 			}
 		}
+
+		template <typename It>
+		void AddBusRoute(const TransportCatalogue& catalog, std::string_view bus, It first, It last) {
+			size_t stops_count = last - first;
+			segments_.resize(segments_.size() + (stops_count - 1) * stops_count / 2);
+
+			ForEachRide(catalog, first, last, [&](graph::VertexId from, graph::VertexId to, int span_count, double distance) {
+				double time = GetRideTime(distance);
+				size_t segment_id = graph_.AddEdge({ from, to, GetEdgeWeight(time) });
+				segments_[segment_id] = { RouteSegment::Type::BUS,
+					std::make_pair(bus, span_count), time, distance };
+			});
+		}
 		void AddBusesToGraph(const TransportCatalogue& catalog);
 	};
 
+	// Routes are precomputed among transfer stops only: stops served by two buses or more, route ends and
+	// stops a route passes twice. Any other stop lies at one place of one route, so a shortest path never
+	// needs to pass through it; a query leaves or enters it with a single ride to or from a transfer stop.
 	class TransportRouter
 	{
 	public:
 		struct TransportRouteInfo {
-			double weight;
+			double weight; // minutes
 			std::vector<const RouteSegment*> segments;
 		};
 
+		struct ReachableStop {
+			std::string_view stop;
+			double time;
+		};
+
+		struct RouteOption {
+			TransportRouteInfo route;
+			size_t transfers;
+		};
+
 		template <typename T>
 		TransportRouter(const TransportCatalogue& catalog, T&& settings)
-			: graph_(catalog, std::forward<T>(settings)), router_(graph_.GetInnerGraph()) {
-
+			: graph_(catalog, std::forward<T>(settings))
+			, raptor_router_(catalog, graph_)
+			, transfer_graph_(BuildTransferGraph(catalog)) {
+			CreateEngine();
 		}
 
-		/* for serialization */
+		/* for serialization: the route table, the landmarks or the labels, whichever the engine keeps;
+		   std::nullopt when the engine keeps nothing */
 		template <typename TransportGraph, typename RouterInternalData>
-		TransportRouter(TransportGraph&& graph, RouterInternalData&& router_data)
-			: graph_(std::forward<TransportGraph>(graph)), router_(graph_.GetInnerGraph(), std::forward<RouterInternalData>(router_data))
+		TransportRouter(const TransportCatalogue& catalog, TransportGraph&& graph, RouterInternalData&& router_data)
+			: graph_(std::forward<TransportGraph>(graph))
+			, raptor_router_(catalog, graph_)
+			, transfer_graph_(BuildTransferGraph(catalog))
 		{
-
+			if constexpr (std::is_same_v<std::decay_t<RouterInternalData>, std::nullopt_t>) {
+				CreateEngine();
+			}
+			else if constexpr (std::is_same_v<std::decay_t<RouterInternalData>, graph::AltRouter<RouteWeight>::Landmarks>) {
+				alt_router_.emplace(graph_.GetInnerGraph(), std::forward<RouterInternalData>(router_data));
+			}
+			else if constexpr (std::is_same_v<std::decay_t<RouterInternalData>, graph::HubLabels<RouteWeight>::Labels>) {
+				hub_labels_.emplace(graph_.GetInnerGraph(), std::forward<RouterInternalData>(router_data));
+			}
+			else {
+				router_.emplace(transfer_graph_, std::forward<RouterInternalData>(router_data));
+			}
+			CreateTreeCache();
+			components_ = graph::FindStronglyConnectedComponents(graph_.GetInnerGraph());
 		}
 
+		// the next version, to apply live changes or new settings to while this one answers: the graph and
+		// whatever the engine precomputed are copied, not rebuilt; only the tree cache starts empty
+		TransportRouter(const TransportRouter& other);
+		TransportRouter& operator=(const TransportRouter&) = delete;
+
 		const TransportGraph& GetTransportGraph() const {
 			return graph_;
 		}
 
-		const graph::Router<double>& GetInnerRouter() const {
-			return router_;
+		const graph::Router<RouteWeight>& GetInnerRouter() const { // over the transfer stops, TRANSFER_TABLE only
+			return router_.value();
+		}
+
+		bool HasInnerRouter() const { // false when the table is over the memory budget
+			return router_.has_value();
+		}
+
+		const graph::AltRouter<RouteWeight>& GetAltRouter() const { // ALT only
+			return alt_router_.value();
+		}
+
+		const graph::HubLabels<RouteWeight>& GetHubLabels() const { // HUB_LABELS only
+			return hub_labels_.value();
 		}
 		/* ----------------- */
 
-		std::optional<TransportRouteInfo> GetShortestRoute(std::string_view from, std::string_view to) const;
-		
+		// hits and misses of the shortest path tree cache; empty when there is none
+		std::optional<graph::ShortestPathTreeCache<RouteWeight>::Stats> GetTreeCacheStats() const;
 
+		std::optional<TransportRouteInfo> GetShortestRoute(std::string_view from, std::string_view to) const;
+		// the fastest route for each number of transfers that pays off, fewest transfers first; found by
+		// RAPTOR whatever the engine. Empty for unknown or unconnected stops
+		std::optional<std::vector<RouteOption>> GetRouteOptions(std::string_view from, std::string_view to) const;
+		// total times only, a row per origin and a column per destination; unknown stops and unreachable
+		// pairs stay empty. Rows are shared among the worker threads
+		std::vector<std::vector<std::optional<double>>> GetRouteMatrix(const std::vector<std::string_view>& from,
+			const std::vector<std::string_view>& to) const;
+		// isochrones: stops reachable within max_time of each origin, fastest first; a bounded search over the
+		// full graph, no precomputed table needed. Empty for an unknown origin
+		std::vector<std::optional<std::vector<ReachableStop>>> GetReachableStops(
+			const std::vector<std::pair<std::string_view, double>>& origins) const;
+		void SetThreadCount(size_t thread_count);
+
+		// new wait time or velocity: the graph is reweighted in place and only the route table or the
+		// landmark distances are recomputed; a new engine is built from scratch
+		void SetSettings(const TransportGraph::Settings& settings);
+
+		// live changes, applied after the same change of the catalogue; added or faster rides are
+		// merged into the route table incrementally, anything else recomputes it
+		void AddBus(const TransportCatalogue& catalog, std::string_view bus);
+		void RemoveBus(const TransportCatalogue& catalog, std::string_view bus);
+		void UpdateBusRoute(const TransportCatalogue& catalog, std::string_view bus);
+		void UpdateDistance(const TransportCatalogue& catalog, std::string_view from, std::string_view to);
 
 	private:
+		static constexpr size_t NO_TRANSFER = std::numeric_limits<size_t>::max();
+
+		// a way into or out of the transfer stops: a ride edge, or none when the stop is a transfer itself
+		struct TransferLink {
+			size_t transfer;
+			std::optional<graph::EdgeId> edge;
+			RouteWeight weight;
+		};
+
+		// the best route found so far: a single ride, or the exit and entry links around the transfer stops
+		struct RouteChoice {
+			RouteWeight weight = std::numeric_limits<RouteWeight>::max();
+			std::optional<graph::EdgeId> direct;
+			size_t exit = NO_TRANSFER;
+			size_t entry = NO_TRANSFER;
+		};
+
 		TransportGraph graph_;
-		graph::Router<double> router_;
+		RaptorRouter raptor_router_; // kept for every engine, it costs one pass over the routes
+		size_t thread_count_ = std::max(1u, std::thread::hardware_concurrency());
+		std::vector<size_t> transfer_by_vertex_;                  // index among transfer stops or NO_TRANSFER
+		std::vector<std::vector<graph::EdgeId>> incoming_edges_;  // filled for non-transfer stops only
+		std::vector<graph::EdgeId> reduced_by_edge_;              // transfer graph edge or NO_TRANSFER
+		std::vector<graph::EdgeId> edge_by_reduced_;
+		graph::DirectedWeightedGraph<RouteWeight> transfer_graph_;
+		std::optional<graph::Router<RouteWeight>> router_;        // TRANSFER_TABLE
+		std::optional<graph::AltRouter<RouteWeight>> alt_router_; // ALT, over the full graph
+		std::optional<graph::HubLabels<RouteWeight>> hub_labels_; // HUB_LABELS, over the full graph
+		// TRANSFER_TABLE over the memory budget: full rows for the most used origins, RAPTOR for the others
+		std::unordered_map<graph::VertexId, graph::ShortestPathTree<RouteWeight>> pinned_rows_;
+		std::optional<graph::ShortestPathTreeCache<RouteWeight>> tree_cache_; // without a table or labels, ahead of the search
+		graph::Components components_; // of the full graph: pairs no route connects are answered before any engine
+
+		void CreateEngine();
+		void RebuildEngine(); // after the graph changed
+		void CreateTreeCache();
+		bool IsTableWithinBudget() const;
+		void PinRows(); // as many as the budget holds
+		std::vector<graph::VertexId> RankOrigins() const;
+
+		std::vector<bool> FindTransferStops(const TransportCatalogue& catalog) const;
+		graph::DirectedWeightedGraph<RouteWeight> BuildTransferGraph(const TransportCatalogue& catalog);
+		void AddToTransferGraph(graph::DirectedWeightedGraph<RouteWeight>& transfer_graph, graph::EdgeId edge_id);
+		void Reduce(const TransportCatalogue& catalog); // transfer graph and routes from scratch
+		void CopyWeightsToTransferGraph();
+		std::vector<TransferLink> GetExits(graph::VertexId from) const;
+		std::vector<TransferLink> GetEntries(graph::VertexId to) const;
+		TransportRouteInfo MakeRouteInfo(RouteWeight weight, const std::vector<graph::EdgeId>& edges) const;
+		std::optional<graph::Router<RouteWeight>::RouteInfo> BuildTransferRoute(graph::VertexId from_id, graph::VertexId to_id) const;
+		void ChooseTransferRoute(const std::vector<TransferLink>& exits, const std::vector<TransferLink>& entries,
+			RouteChoice& choice) const;
+
+		// task(i) for every i below count, spread over the worker threads when there are enough of them
+		template <typename Task>
+		void RunParallel(size_t count, Task task) const {
+			const size_t thread_count = count >= PARALLEL_MIN_ORIGINS ? std::min(thread_count_, count) : 1;
+			std::atomic_size_t next = 0;
+			auto worker = [&]() {
+				for (size_t i = next++; i < count; i = next++) {
+					task(i);
+				}
+			};
+			std::vector<std::future<void>> workers;
+			for (size_t i = 1; i < thread_count; ++i) {
+				workers.push_back(std::async(std::launch::async, worker));
+			}
+			worker();
+			for (auto& future : workers) {
+				future.get();
+			}
+		}
 	};
 }
-